@@ -0,0 +1,434 @@
+#include "arcrasterizer.h"
+#include <QPaintEngine>
+#include <QPainter>
+#include <QRegion>
+#include <QTransform>
+#include <QtMath>
+#include <cmath>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ARCRASTERIZER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Round caps with a smaller radius are integrated row by row; the disc's
+// edge is too curved within one pixel for a straight-edge estimate
+constexpr float ThinRoundCap = 1.0f;
+constexpr int ThinCapRows = 16;
+
+// How a straight edge crosses a pixel, from its unit normal: hi and lo are
+// the larger and smaller absolute component
+struct EdgeSlope {
+    float hi, lo;
+    float invHi, invHiLo2;  // 1 / hi and 1 / (2 hi lo)
+};
+
+EdgeSlope edgeSlope(float nx, float ny) {
+    EdgeSlope slope;
+    slope.hi = qMax(qMax(std::fabs(nx), std::fabs(ny)), float(M_SQRT1_2));
+    slope.lo = qMax(qMin(std::fabs(nx), std::fabs(ny)), 1.0f / 256);
+    slope.invHi = 1.0f / slope.hi;
+    slope.invHiLo2 = 0.5f / (slope.hi * slope.lo);
+    return slope;
+}
+
+// Everything relative to the circle's center, in device pixels
+struct ArcShape {
+    float cx, cy;
+    float radius, halfWidth;
+    float u0x, u0y, u1x, u1y;  // unit vectors towards both ends
+    float e0x, e0y, e1x, e1y;  // ends on the center line
+    EdgeSlope end0, end1;      // of the cuts through the ends, and of the ends' radii
+    float capLength;           // square caps as boxes past the ends
+    bool discCaps;             // round caps as discs
+    bool thinCaps;             // round caps as half discs measured per row
+    float capReach2;           // squared distance from an end where its cap ends
+    bool full;                 // no sector test
+    bool wide;                 // more than half a turn, inside either half-plane
+    bool facing;               // the cuts are closer to opposite than to parallel
+};
+
+// Blends color scaled by coverage over a premultiplied pixel, the way the
+// raster engine blends antialiased spans of a solid color
+inline uint byteMul(uint x, uint a) {
+    uint t = (x & 0xff00ff) * a;
+    t = (t + ((t >> 8) & 0xff00ff) + 0x800080) >> 8;
+    t &= 0xff00ff;
+    x = ((x >> 8) & 0xff00ff) * a;
+    x = (x + ((x >> 8) & 0xff00ff) + 0x800080);
+    x &= 0xff00ff00;
+    return x | t;
+}
+
+inline void blendPixel(QRgb *pixel, QRgb color, int coverage) {
+    if (coverage <= 0) return;
+    QRgb src = coverage >= 255 ? color : byteMul(color, uint(coverage));
+    *pixel = src + byteMul(*pixel, 255 - qAlpha(src));
+}
+
+// Area of the pixel on the inner side of a straight edge t pixels away from
+// its center. Across the edge the pixel's footprint is a trapezoid, so the
+// area grows quadratically at both corners and linearly in between.
+inline float edgeCoverage(float t, float hi, float lo, float invHi, float invHiLo2) {
+    float s = qBound(0.0f, t + 0.5f * (hi + lo), hi + lo);
+    float in = qMax(lo - s, 0.0f), out = qMax(s - hi, 0.0f);
+    return (s - 0.5f * lo) * invHi + (in * in - out * out) * invHiLo2;
+}
+
+inline float edgeCoverage(float t, const EdgeSlope &slope) {
+    return edgeCoverage(t, slope.hi, slope.lo, slope.invHi, slope.invHiLo2);
+}
+
+// Coverage of a cap, the part of it past the cut whose own coverage is cut
+inline float capCoverage(const ArcShape &a, float ux, float uy, float ex, float ey, const EdgeSlope &slope,
+                         float side, float cut, float px, float py) {
+    float dx = px - ex, dy = py - ey;
+    if (dx * dx + dy * dy >= a.capReach2) return 0.0f;
+    if (a.discCaps) {
+        float dist = std::sqrt(dx * dx + dy * dy);
+        float r = qMax(dist, 1e-3f);
+        // Moving the edge in a little accounts for its curvature within the pixel
+        float disc = edgeCoverage(a.halfWidth - dist - 0.06f / a.halfWidth, edgeSlope(dx / r, dy / r));
+        return qMin(disc, float(M_PI) * a.halfWidth * a.halfWidth) * (1.0f - cut);
+    }
+    float q = px * ux + py * uy - a.radius;
+    float across = edgeCoverage(a.halfWidth - q, slope) - edgeCoverage(-a.halfWidth - q, slope);
+    return across * (edgeCoverage(side + a.capLength, slope) - cut);
+}
+
+// Area of a thin round cap within the pixel, the half disc around the end
+// where sx x + sy y < 0, summed over rows of the pixel or, when the cut is
+// closer to horizontal, over its columns
+inline float thinCapCoverage(const ArcShape &a, float sx, float sy, float ex, float ey, float px, float py) {
+    float dx = px - ex, dy = py - ey;
+    if (dx * dx + dy * dy >= a.capReach2) return 0.0f;
+    if (std::fabs(sx) < std::fabs(sy)) {
+        std::swap(sx, sy);
+        std::swap(ex, ey);
+        std::swap(px, py);
+    }
+    float area = 0.0f;
+    for (int i = 0; i < ThinCapRows; ++i) {
+        float y = py + (i + 0.5f) / ThinCapRows - 0.5f;
+        float h = a.halfWidth * a.halfWidth - (y - ey) * (y - ey);
+        if (h <= 0.0f) continue;
+        float chord = std::sqrt(h);
+        float x0 = qMax(px - 0.5f, ex - chord), x1 = qMin(px + 0.5f, ex + chord);
+        float limit = -sy * y / sx;
+        if (sx > 0.0f) x1 = qMin(x1, limit);
+        else x0 = qMax(x0, limit);
+        area += qMax(x1 - x0, 0.0f);
+    }
+    return area / ThinCapRows;
+}
+
+// Coverage in 0..1 of the pixel centered at (px, py): the band between both
+// circles, cut by the sector and extended by the caps
+inline float coverage(const ArcShape &a, float px, float py) {
+    float r = qMax(std::sqrt(px * px + py * py), 1e-3f);
+    float nx = std::fabs(px) / r, ny = std::fabs(py) / r;
+    float hi = qMax(qMax(nx, ny), float(M_SQRT1_2));
+    float lo = qMax(qMin(nx, ny), 1.0f / 256);
+    float invHi = 1.0f / hi, invHiLo2 = 0.5f / (hi * lo);
+    float d = r - a.radius;
+    float band = edgeCoverage(a.halfWidth - d, hi, lo, invHi, invHiLo2)
+        - edgeCoverage(-a.halfWidth - d, hi, lo, invHi, invHiLo2);
+    if (a.full) return qBound(0.0f, band, 1.0f);
+
+    float side0 = a.u0y * px - a.u0x * py;
+    float side1 = a.u1x * py - a.u1y * px;
+    float cut0 = edgeCoverage(side0, a.end0);
+    float cut1 = edgeCoverage(side1, a.end1);
+    // Cuts crossing one pixel overlap like parallel edges or, for spans near
+    // zero or a full turn, like opposite ones
+    float sector = a.wide ? (a.facing ? qMin(cut0 + cut1, 1.0f) : qMax(cut0, cut1))
+                          : (a.facing ? qMax(cut0 + cut1 - 1.0f, 0.0f) : qMin(cut0, cut1));
+    float cov = band * sector;
+    if (a.thinCaps) {
+        cov += thinCapCoverage(a, a.u0y, -a.u0x, a.e0x, a.e0y, px, py);
+        cov += thinCapCoverage(a, -a.u1y, a.u1x, a.e1x, a.e1y, px, py);
+    } else if (a.capLength > 0 || a.discCaps) {
+        cov += capCoverage(a, a.u0x, a.u0y, a.e0x, a.e0y, a.end0, side0, cut0, px, py);
+        cov += capCoverage(a, a.u1x, a.u1y, a.e1x, a.e1y, a.end1, side1, cut1, px, py);
+    }
+    return qBound(0.0f, cov, 1.0f);
+}
+
+#ifdef ARCRASTERIZER_SSE2
+inline __m128 absPs(__m128 v) {
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f), v);
+}
+
+inline __m128 edgeCoverage4(__m128 t, __m128 hi, __m128 lo, __m128 invHi, __m128 invHiLo2) {
+    const __m128 half = _mm_set1_ps(0.5f), zero = _mm_setzero_ps();
+    __m128 width = _mm_add_ps(hi, lo);
+    __m128 s = _mm_min_ps(_mm_max_ps(_mm_add_ps(t, _mm_mul_ps(half, width)), zero), width);
+    __m128 in = _mm_max_ps(_mm_sub_ps(lo, s), zero), out = _mm_max_ps(_mm_sub_ps(s, hi), zero);
+    __m128 linear = _mm_mul_ps(_mm_sub_ps(s, _mm_mul_ps(half, lo)), invHi);
+    __m128 corners = _mm_sub_ps(_mm_mul_ps(in, in), _mm_mul_ps(out, out));
+    return _mm_add_ps(linear, _mm_mul_ps(corners, invHiLo2));
+}
+
+inline __m128 edgeCoverage4(__m128 t, const EdgeSlope &slope) {
+    return edgeCoverage4(t, _mm_set1_ps(slope.hi), _mm_set1_ps(slope.lo), _mm_set1_ps(slope.invHi),
+                         _mm_set1_ps(slope.invHiLo2));
+}
+
+// capCoverage() for four pixels, skipped when none of them reaches the cap
+inline __m128 capCoverage4(const ArcShape &a, float ux, float uy, float ex, float ey, const EdgeSlope &slope,
+                           __m128 side, __m128 cut, __m128 px, __m128 py) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 halfWidth = _mm_set1_ps(a.halfWidth);
+    __m128 dx = _mm_sub_ps(px, _mm_set1_ps(ex));
+    __m128 dy = _mm_sub_ps(py, _mm_set1_ps(ey));
+    __m128 near = _mm_cmplt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_set1_ps(a.capReach2));
+    if (!_mm_movemask_ps(near)) return _mm_setzero_ps();
+
+    __m128 cov;
+    if (a.discCaps) {
+        __m128 dist = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+        __m128 r = _mm_max_ps(dist, _mm_set1_ps(1e-3f));
+        __m128 nx = _mm_div_ps(absPs(dx), r), ny = _mm_div_ps(absPs(dy), r);
+        __m128 hi = _mm_max_ps(_mm_max_ps(nx, ny), _mm_set1_ps(float(M_SQRT1_2)));
+        __m128 lo = _mm_max_ps(_mm_min_ps(nx, ny), _mm_set1_ps(1.0f / 256));
+        __m128 invHi = _mm_div_ps(one, hi);
+        __m128 invHiLo2 = _mm_div_ps(_mm_set1_ps(0.5f), _mm_mul_ps(hi, lo));
+        __m128 t = _mm_sub_ps(_mm_sub_ps(halfWidth, dist), _mm_set1_ps(0.06f / a.halfWidth));
+        __m128 disc = _mm_min_ps(edgeCoverage4(t, hi, lo, invHi, invHiLo2),
+                                 _mm_set1_ps(float(M_PI) * a.halfWidth * a.halfWidth));
+        cov = _mm_mul_ps(disc, _mm_sub_ps(one, cut));
+    } else {
+        __m128 q = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(ux)), _mm_mul_ps(py, _mm_set1_ps(uy))),
+                              _mm_set1_ps(a.radius));
+        __m128 across = _mm_sub_ps(edgeCoverage4(_mm_sub_ps(halfWidth, q), slope),
+                                   edgeCoverage4(_mm_sub_ps(_mm_sub_ps(_mm_setzero_ps(), halfWidth), q), slope));
+        __m128 along = _mm_sub_ps(edgeCoverage4(_mm_add_ps(side, _mm_set1_ps(a.capLength)), slope), cut);
+        cov = _mm_mul_ps(across, along);
+    }
+    return _mm_and_ps(near, cov);
+}
+
+// Thin caps of four pixels of one row, per pixel for the few near an end
+inline __m128 thinCapCoverage4(const ArcShape &a, __m128 px, float py) {
+    const __m128 reach = _mm_set1_ps(a.capReach2);
+    const __m128 dy0 = _mm_set1_ps((py - a.e0y) * (py - a.e0y));
+    const __m128 dy1 = _mm_set1_ps((py - a.e1y) * (py - a.e1y));
+    __m128 dx0 = _mm_sub_ps(px, _mm_set1_ps(a.e0x)), dx1 = _mm_sub_ps(px, _mm_set1_ps(a.e1x));
+    __m128 near = _mm_or_ps(_mm_cmplt_ps(_mm_add_ps(_mm_mul_ps(dx0, dx0), dy0), reach),
+                            _mm_cmplt_ps(_mm_add_ps(_mm_mul_ps(dx1, dx1), dy1), reach));
+    if (!_mm_movemask_ps(near)) return _mm_setzero_ps();
+
+    alignas(16) float x[4];
+    _mm_store_ps(x, px);
+    for (float &v : x)
+        v = thinCapCoverage(a, a.u0y, -a.u0x, a.e0x, a.e0y, v, py)
+            + thinCapCoverage(a, -a.u1y, a.u1x, a.e1x, a.e1y, v, py);
+    return _mm_load_ps(x);
+}
+
+// coverage() for four pixels of one row
+inline __m128 coverage4(const ArcShape &a, __m128 px, __m128 py) {
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+    __m128 r = _mm_max_ps(_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(px, px), _mm_mul_ps(py, py))), _mm_set1_ps(1e-3f));
+    __m128 nx = _mm_div_ps(absPs(px), r), ny = _mm_div_ps(absPs(py), r);
+    __m128 hi = _mm_max_ps(_mm_max_ps(nx, ny), _mm_set1_ps(float(M_SQRT1_2)));
+    __m128 lo = _mm_max_ps(_mm_min_ps(nx, ny), _mm_set1_ps(1.0f / 256));
+    __m128 invHi = _mm_div_ps(one, hi);
+    __m128 invHiLo2 = _mm_div_ps(_mm_set1_ps(0.5f), _mm_mul_ps(hi, lo));
+    __m128 d = _mm_sub_ps(r, _mm_set1_ps(a.radius));
+    __m128 halfWidth = _mm_set1_ps(a.halfWidth);
+    __m128 band = _mm_sub_ps(edgeCoverage4(_mm_sub_ps(halfWidth, d), hi, lo, invHi, invHiLo2),
+                             edgeCoverage4(_mm_sub_ps(_mm_sub_ps(zero, halfWidth), d), hi, lo, invHi, invHiLo2));
+    if (a.full) return _mm_min_ps(_mm_max_ps(band, zero), one);
+
+    __m128 side0 = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(a.u0y), px), _mm_mul_ps(_mm_set1_ps(a.u0x), py));
+    __m128 side1 = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(a.u1x), py), _mm_mul_ps(_mm_set1_ps(a.u1y), px));
+    __m128 cut0 = edgeCoverage4(side0, a.end0);
+    __m128 cut1 = edgeCoverage4(side1, a.end1);
+    __m128 sector;
+    if (a.wide)
+        sector = a.facing ? _mm_min_ps(_mm_add_ps(cut0, cut1), one) : _mm_max_ps(cut0, cut1);
+    else
+        sector = a.facing ? _mm_max_ps(_mm_sub_ps(_mm_add_ps(cut0, cut1), one), zero) : _mm_min_ps(cut0, cut1);
+    __m128 cov = _mm_mul_ps(band, sector);
+    if (a.thinCaps) {
+        cov = _mm_add_ps(cov, thinCapCoverage4(a, px, _mm_cvtss_f32(py)));
+    } else if (a.capLength > 0 || a.discCaps) {
+        cov = _mm_add_ps(cov, capCoverage4(a, a.u0x, a.u0y, a.e0x, a.e0y, a.end0, side0, cut0, px, py));
+        cov = _mm_add_ps(cov, capCoverage4(a, a.u1x, a.u1y, a.e1x, a.e1y, a.end1, side1, cut1, px, py));
+    }
+    return _mm_min_ps(_mm_max_ps(cov, zero), one);
+}
+#endif
+
+// Pixels [x0, x1) of one row, py relative to the center
+void fillSpan(QRgb *line, int x0, int x1, float py, const ArcShape &a, QRgb color) {
+    int x = x0;
+#ifdef ARCRASTERIZER_SSE2
+    const __m128 offsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+    const __m128 rows = _mm_set1_ps(py);
+    for (; x + 4 <= x1; x += 4) {
+        __m128 px = _mm_add_ps(_mm_set1_ps(float(x) - a.cx), offsets);
+        __m128i levels = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(coverage4(a, px, rows), _mm_set1_ps(255.0f)),
+                                                     _mm_set1_ps(0.5f)));
+        // Most groups along a thin ring are entirely outside it
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(levels, _mm_setzero_si128())) == 0xffff) continue;
+
+        alignas(16) int lane[4];
+        _mm_store_si128(reinterpret_cast<__m128i *>(lane), levels);
+        for (int i = 0; i < 4; ++i) blendPixel(line + x + i, color, lane[i]);
+    }
+#endif
+    for (; x < x1; ++x)
+        blendPixel(line + x, color, int(coverage(a, float(x) - a.cx + 0.5f, py) * 255.0f + 0.5f));
+}
+
+// Whether angle (degrees, counter-clockwise) lies on the arc from start over span
+bool onArc(qreal angle, qreal start, qreal span) {
+    qreal offset = std::fmod(angle - start, 360.0);
+    if (offset < 0) offset += 360.0;
+    return offset <= span;
+}
+
+}
+
+bool ArcRasterizer::drawArc(QPainter *painter, const QRectF &rect, int startAngle, int spanAngle) {
+    QPaintEngine *engine = painter->paintEngine();
+    if (!engine || engine->type() != QPaintEngine::Raster || painter->hasClipping()
+        || !painter->testRenderHint(QPainter::Antialiasing)
+        || painter->compositionMode() != QPainter::CompositionMode_SourceOver) {
+        return false;
+    }
+
+    // Widgets on a raster backing store end up here too, the engine's device
+    // is then the backing store image rather than the widget
+    QPaintDevice *device = engine->paintDevice();
+    if (!device || device->devType() != QInternal::Image) return false;
+
+    const QTransform transform = painter->deviceTransform();
+    if (transform.type() > QTransform::TxScale || transform.m11() != transform.m22() || transform.m11() <= 0)
+        return false;
+
+    const QPen &pen = painter->pen();
+    if (pen.style() != Qt::SolidLine || pen.brush().style() != Qt::SolidPattern || pen.widthF() <= 0) return false;
+
+    qreal width = pen.isCosmetic() ? pen.widthF() : pen.widthF() * transform.m11();
+    QColor color = pen.color();
+    color.setAlphaF(color.alphaF() * painter->opacity());
+    QRgb premultiplied = qPremultiply(color.rgba());
+
+    auto *image = static_cast<QImage *>(device);
+    QRectF deviceRect = transform.mapRect(rect);
+    QRegion clip = engine->systemClip();
+    if (clip.isEmpty())
+        return fillArc(image, image->rect(), deviceRect, width, pen.capStyle(), startAngle, spanAngle, premultiplied);
+
+    // Every rect passes the same checks, so only the first can refuse
+    for (const QRect &area : clip) {
+        if (!fillArc(image, area, deviceRect, width, pen.capStyle(), startAngle, spanAngle, premultiplied))
+            return false;
+    }
+    return true;
+}
+
+bool ArcRasterizer::fillArc(QImage *image, const QRect &clip, const QRectF &rect, qreal penWidth,
+                            Qt::PenCapStyle cap, int startAngle, int spanAngle, QRgb color) {
+    if (!image || (image->format() != QImage::Format_ARGB32_Premultiplied && image->format() != QImage::Format_RGB32))
+        return false;
+    // QPainter leaves zero spans to the stroker's cap handling
+    if (spanAngle == 0 || penWidth <= 0 || rect.width() <= 0 || !qFuzzyCompare(rect.width(), rect.height()))
+        return false;
+
+    qreal start = startAngle / 16.0;
+    qreal span = spanAngle / 16.0;
+    if (span < 0) {
+        start += span;
+        span = -span;
+    }
+
+    ArcShape arc;
+    arc.cx = float(rect.center().x());
+    arc.cy = float(rect.center().y());
+    arc.radius = float(rect.width() / 2);
+    arc.halfWidth = float(penWidth / 2);
+    arc.full = span >= 360.0;
+    arc.wide = span > 180.0;
+    arc.facing = span < 90.0 || span > 270.0;
+
+    // Screen y points down, so counter-clockwise angles negate it
+    qreal a0 = qDegreesToRadians(start), a1 = qDegreesToRadians(start + span);
+    arc.u0x = float(std::cos(a0));
+    arc.u0y = float(-std::sin(a0));
+    arc.u1x = float(std::cos(a1));
+    arc.u1y = float(-std::sin(a1));
+    arc.e0x = arc.u0x * arc.radius;
+    arc.e0y = arc.u0y * arc.radius;
+    arc.e1x = arc.u1x * arc.radius;
+    arc.e1y = arc.u1y * arc.radius;
+    arc.end0 = edgeSlope(arc.u0x, arc.u0y);
+    arc.end1 = edgeSlope(arc.u1x, arc.u1y);
+
+    // A full turn is closed, QPainter joins it instead of drawing caps
+    arc.discCaps = cap == Qt::RoundCap && arc.halfWidth >= ThinRoundCap;
+    arc.thinCaps = cap == Qt::RoundCap && !arc.discCaps;
+    arc.capLength = cap == Qt::SquareCap ? arc.halfWidth : 0.0f;
+    float capReach = float(M_SQRT2) * arc.halfWidth + arc.capLength + 1.5f;
+    arc.capReach2 = capReach * capReach;
+
+    // Square caps reach past the outer edge with their corners
+    float outer = arc.radius + arc.halfWidth;
+    if (cap == Qt::SquareCap) outer = std::sqrt(outer * outer + arc.halfWidth * arc.halfWidth);
+    outer += 1.0f;
+    float inner = arc.radius - arc.halfWidth - 1.0f;
+
+    // Bounding box of the sector: both caps and the outermost points it passes
+    qreal pad = (cap == Qt::SquareCap ? M_SQRT2 : 1.0) * arc.halfWidth + 1.0;
+    QRectF bounds(QPointF(arc.e0x - pad, arc.e0y - pad), QPointF(arc.e0x + pad, arc.e0y + pad));
+    bounds |= QRectF(QPointF(arc.e1x - pad, arc.e1y - pad), QPointF(arc.e1x + pad, arc.e1y + pad));
+    for (int quadrant = 0; quadrant < 4; ++quadrant) {
+        if (!arc.full && !onArc(quadrant * 90, start, span)) continue;
+        QPointF extreme(quadrant == 0 ? outer : quadrant == 2 ? -outer : 0,
+                        quadrant == 1 ? -outer : quadrant == 3 ? outer : 0);
+        bounds |= QRectF(extreme - QPointF(1, 1), extreme + QPointF(1, 1));
+    }
+    QRect area = bounds.translated(arc.cx, arc.cy).toAlignedRect() & clip & image->rect();
+    if (area.isEmpty()) return true;
+
+    // The engine writes to the same memory; bits() could detach from it
+    uchar *bits = const_cast<uchar *>(image->constBits());
+    const qsizetype stride = image->bytesPerLine();
+
+    for (int y = area.top(); y <= area.bottom(); ++y) {
+        float py = float(y) + 0.5f - arc.cy;
+        if (std::fabs(py) >= outer) continue;
+
+        // Pixels whose center lies within the outer circle, minus the hole
+        float reach = std::sqrt(outer * outer - py * py);
+        int left = qMax(area.left(), int(std::ceil(arc.cx - reach - 0.5f)));
+        int right = qMin(area.right(), int(std::floor(arc.cx + reach - 0.5f)));
+        if (left > right) continue;
+
+        QRgb *line = reinterpret_cast<QRgb *>(bits + y * stride);
+        if (inner > 0 && std::fabs(py) < inner) {
+            float hole = std::sqrt(inner * inner - py * py);
+            int holeLeft = int(std::floor(arc.cx - hole - 0.5f));
+            int holeRight = int(std::ceil(arc.cx + hole - 0.5f));
+            fillSpan(line, left, qMin(right, holeLeft) + 1, py, arc, color);
+            fillSpan(line, qMax(left, holeRight), right + 1, py, arc, color);
+        } else {
+            fillSpan(line, left, right + 1, py, arc, color);
+        }
+    }
+    return true;
+}
+
+bool ArcRasterizer::isVectorized() {
+#ifdef ARCRASTERIZER_SSE2
+    return true;
+#else
+    return false;
+#endif
+}
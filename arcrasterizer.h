@@ -0,0 +1,39 @@
+#ifndef ARCRASTERIZER_H
+#define ARCRASTERIZER_H
+
+#include <QImage>
+#include <QRect>
+#include <QRectF>
+
+class QPainter;
+class QPen;
+
+// Strokes circular arcs without QPainter's path stroker. Each pixel near the
+// arc gets the area it shares with the annulus sector and its caps, four
+// pixels at a time with SSE2 where available, and only rows and spans that
+// can reach the arc are visited.
+//
+// The area is estimated from straight edges through the pixel and stays
+// within 8 of 255 levels of a supersampled fill of the exact outline. The
+// stroker flattens the circles into short lines, so the two backends differ
+// by up to about 90 levels on thin pens; arcrasterizertest bounds both.
+class ArcRasterizer {
+public:
+    // Same arguments and result as painter->drawArc() with the current pen,
+    // drawn straight into the QImage under the painter's raster engine.
+    // Returns false without drawing when that isn't possible (not a raster
+    // image, rotation or clipping, ellipses, non-solid pens, aliased or
+    // non-SourceOver painting, empty spans); call drawArc() then.
+    static bool drawArc(QPainter *painter, const QRectF &rect, int startAngle, int spanAngle);
+
+    // The rasterizer itself, in device pixels. rect is the circle's bounding
+    // square, angles are in 1/16th of a degree as for drawArc(), color is
+    // premultiplied. Only pixels inside clip are written.
+    static bool fillArc(QImage *image, const QRect &clip, const QRectF &rect, qreal penWidth,
+                        Qt::PenCapStyle cap, int startAngle, int spanAngle, QRgb color);
+
+    // Whether the inner loop was built with SSE2
+    static bool isVectorized();
+};
+
+#endif // ARCRASTERIZER_H
@@ -0,0 +1,322 @@
+#include <QApplication>
+#include <QPainter>
+#include <QPainterPath>
+#include <QRegion>
+#include <QTextStream>
+#include <QTransform>
+#include <QVector>
+#include <QWidget>
+#include <QtMath>
+#include "arcrasterizer.h"
+#include "circularprogressrenderer.h"
+
+// Pixel checks for ArcRasterizer, run by ctest.
+// Every arc is compared with a supersampled fill of the exact stroke outline,
+// drawn straight into images and through a widget's partial repaint with the
+// AnalyticArcs backend, where the engine's system clip limits it. The same
+// arcs are also compared with QPainter::drawArc(), which catches geometry the
+// outline and the rasterizer could both get wrong. Exits with 1 when any arc
+// could not be drawn or is further off than allowed.
+
+namespace {
+
+// Largest channel difference allowed from the exact outline
+constexpr int Tolerance = 8;
+
+// QPainter's stroker flattens the circles, so against drawArc() the bounds
+// are wider: measured at most 89 levels and a mean of 22 over the changed
+// pixels for pens under two device pixels, 64 and 7 for wider ones
+struct StrokerTolerance {
+    int max;
+    double mean;
+};
+constexpr StrokerTolerance ThinStroker = {100, 25.0};
+constexpr StrokerTolerance WideStroker = {72, 10.0};
+
+const QColor Background(20, 20, 20, 200);
+
+struct Case {
+    int size;
+    qreal width;
+    bool cosmetic;
+    Qt::PenCapStyle cap;
+    qreal progress;
+    qreal dpr;
+
+    // Integer like the bar's ring rect, which drawProgress() takes
+    QRect rect() const {
+        const int inset = int(width);
+        return QRect(inset, inset, size - 2 * inset, size - 2 * inset);
+    }
+    qreal deviceWidth() const { return cosmetic ? width : width * dpr; }
+    int spanAngle() const { return int(-(progress * 360 * 16)); }
+    QColor color() const { return int(progress * 100) % 2 ? QColor(73, 139, 209) : QColor(230, 126, 34, 140); }
+
+    QPen pen() const {
+        QPen pen(color());
+        pen.setWidthF(width);
+        pen.setCosmetic(cosmetic);
+        pen.setCapStyle(cap);
+        return pen;
+    }
+
+    QString name() const {
+        return QString("size %1 width %2%3 cap %4 progress %5 dpr %6")
+            .arg(size).arg(width).arg(cosmetic ? " cosmetic" : "")
+            .arg(int(cap)).arg(progress).arg(dpr);
+    }
+};
+
+// What drawArc() strokes as one closed outline in device pixels: both circles
+// between the ends, joined by the caps. A full turn is closed and has none.
+QPainterPath arcOutline(const QRectF &rect, qreal width, Qt::PenCapStyle cap, int startAngle, int spanAngle) {
+    qreal start = startAngle / 16.0;
+    qreal span = spanAngle / 16.0;
+    if (span < 0) {
+        start += span;
+        span = -span;
+    }
+    if (span >= 360.0) {
+        span = 360.0;
+        cap = Qt::FlatCap;
+    }
+    const QPointF center = rect.center();
+    const qreal radius = rect.width() / 2, halfWidth = width / 2;
+    auto square = [](const QPointF &c, qreal r) { return QRectF(c.x() - r, c.y() - r, 2 * r, 2 * r); };
+    auto point = [&](qreal r, qreal angle) {
+        qreal a = qDegreesToRadians(angle);
+        return center + QPointF(std::cos(a), -std::sin(a)) * r;
+    };
+    // Towards increasing angles on screen
+    auto tangent = [](qreal angle) {
+        qreal a = qDegreesToRadians(angle);
+        return QPointF(-std::sin(a), -std::cos(a));
+    };
+
+    QPainterPath path;
+    // QPainterPath spends one curve per quarter turn, which is visibly off
+    // the circle on large rings; short curves stay on it
+    auto arcTo = [&](const QRectF &circle, qreal from, qreal sweep) {
+        const int pieces = qMax(1, qCeil(std::fabs(sweep) / 10));
+        for (int i = 0; i < pieces; ++i) path.arcTo(circle, from + sweep * i / pieces, sweep / pieces);
+    };
+
+    const qreal end = start + span;
+    path.arcMoveTo(square(center, radius + halfWidth), start);
+    arcTo(square(center, radius + halfWidth), start, span);
+    if (cap == Qt::SquareCap) {
+        path.lineTo(point(radius + halfWidth, end) + tangent(end) * halfWidth);
+        path.lineTo(point(radius - halfWidth, end) + tangent(end) * halfWidth);
+    } else if (cap == Qt::RoundCap) {
+        arcTo(square(point(radius, end), halfWidth), end, 180);
+    }
+    path.lineTo(point(radius - halfWidth, end));
+    arcTo(square(center, radius - halfWidth), end, -span);
+    if (cap == Qt::SquareCap) {
+        path.lineTo(point(radius - halfWidth, start) - tangent(start) * halfWidth);
+        path.lineTo(point(radius + halfWidth, start) - tangent(start) * halfWidth);
+    } else if (cap == Qt::RoundCap) {
+        arcTo(square(point(radius, start), halfWidth), start + 180, 180);
+    }
+    path.closeSubpath();
+    return path;
+}
+
+// Fills path over image eight times larger and averages that down, close to
+// the exact area coverage of every pixel. Works through bands of rows so the
+// large image stays small.
+void fillReference(QImage *image, const QPainterPath &path, const QColor &color) {
+    constexpr int Scale = 8, Rows = 16;
+    QImage band(image->width() * Scale, Rows * Scale, QImage::Format_ARGB32_Premultiplied);
+    for (int top = 0; top < image->height(); top += Rows) {
+        const int rows = qMin(Rows, image->height() - top);
+        for (int y = 0; y < rows * Scale; ++y) {
+            const QRgb *source = reinterpret_cast<const QRgb *>(image->constScanLine(top + y / Scale));
+            QRgb *line = reinterpret_cast<QRgb *>(band.scanLine(y));
+            for (int x = 0; x < band.width(); ++x) line[x] = source[x / Scale];
+        }
+
+        QPainter painter(&band);
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.scale(Scale, Scale);
+        painter.translate(0, -top);
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(color);
+        painter.drawPath(path);
+        painter.end();
+
+        for (int y = 0; y < rows; ++y) {
+            QRgb *line = reinterpret_cast<QRgb *>(image->scanLine(top + y));
+            for (int x = 0; x < image->width(); ++x) {
+                int sum[4] = {};
+                for (int sy = 0; sy < Scale; ++sy) {
+                    const QRgb *source = reinterpret_cast<const QRgb *>(band.constScanLine(y * Scale + sy));
+                    for (int sx = 0; sx < Scale; ++sx) {
+                        QRgb v = source[x * Scale + sx];
+                        sum[0] += qRed(v);
+                        sum[1] += qGreen(v);
+                        sum[2] += qBlue(v);
+                        sum[3] += qAlpha(v);
+                    }
+                }
+                const int n = Scale * Scale;
+                line[x] = qRgba((sum[0] + n / 2) / n, (sum[1] + n / 2) / n, (sum[2] + n / 2) / n, (sum[3] + n / 2) / n);
+            }
+        }
+    }
+}
+
+QImage blank(const Case &c) {
+    QImage image(QSize(c.size, c.size) * c.dpr, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Background);
+    return image;
+}
+
+// The whole arc in device pixels; cosmetic pens keep their width
+QImage reference(const Case &c) {
+    QImage image = blank(c);
+    const QRectF rect = c.rect();
+    const QRectF deviceRect(rect.topLeft() * c.dpr, rect.size() * c.dpr);
+    fillReference(&image, arcOutline(deviceRect, c.deviceWidth(), c.cap, 90 * 16, c.spanAngle()), c.color());
+    return image;
+}
+
+// The same arc from QPainter's own stroker
+QImage stroked(const Case &c) {
+    QImage image = blank(c);
+    image.setDevicePixelRatio(c.dpr);
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(c.pen());
+    painter.drawArc(c.rect(), 90 * 16, c.spanAngle());
+    return image;
+}
+
+struct Difference {
+    int max = 0;
+    double mean = 0;       // over the pixels either image changed
+    bool outside = false;  // a pixel outside the clip was written
+};
+
+Difference difference(const QImage &expected, const QImage &actual, const QImage &before, const QRegion &clip) {
+    Difference result;
+    qint64 total = 0, changed = 0;
+    for (int y = 0; y < expected.height(); ++y) {
+        const QRgb *a = reinterpret_cast<const QRgb *>(expected.constScanLine(y));
+        const QRgb *b = reinterpret_cast<const QRgb *>(actual.constScanLine(y));
+        const QRgb *untouched = reinterpret_cast<const QRgb *>(before.constScanLine(y));
+        for (int x = 0; x < expected.width(); ++x) {
+            if (!clip.contains(QPoint(x, y))) {
+                if (b[x] != untouched[x]) result.outside = true;
+                continue;
+            }
+            if (a[x] == untouched[x] && b[x] == untouched[x]) continue;
+            int diff = qMax(qMax(qAbs(qRed(a[x]) - qRed(b[x])), qAbs(qGreen(a[x]) - qGreen(b[x]))),
+                            qMax(qAbs(qBlue(a[x]) - qBlue(b[x])), qAbs(qAlpha(a[x]) - qAlpha(b[x]))));
+            result.max = qMax(result.max, diff);
+            total += diff;
+            ++changed;
+        }
+    }
+    result.mean = changed ? double(total) / changed : 0.0;
+    return result;
+}
+
+// Paints one arc through the renderer as the bar does, so render() hands the
+// repainted region to the raster engine as its system clip. A fallback to
+// the stroker shows up as a difference from the exact outline.
+class ArcWidget : public QWidget {
+public:
+    explicit ArcWidget(const Case &c) : m_case(c) { resize(c.size, c.size); }
+
+protected:
+    void paintEvent(QPaintEvent *) override {
+        QPainter painter(this);
+        painter.setRenderHint(QPainter::Antialiasing);
+        CircularProgressRenderer::drawProgress(&painter, m_case.rect(), m_case.pen(), m_case.progress, 360);
+    }
+
+private:
+    Case m_case;
+};
+
+}
+
+int main(int argc, char *argv[]) {
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+    QTextStream log(stderr);
+    int count = 0, failures = 0, worst = 0, worstStroker = 0;
+    double worstStrokerMean = 0;
+    auto fail = [&](const char *how, const Case &c, const QString &why) {
+        ++failures;
+        log << how << ' ' << c.name() << ": " << why << '\n';
+    };
+    auto check = [&](const char *how, const Case &c, const Difference &diff) {
+        ++count;
+        worst = qMax(worst, diff.max);
+        if (diff.outside) fail(how, c, "wrote outside the clip");
+        else if (diff.max > Tolerance) fail(how, c, QString("differs by %1").arg(diff.max));
+    };
+
+    QVector<Case> cases;
+    for (int size : {24, 48, 97, 200})
+        for (qreal width : {1.0, 2.5, 10.0, 24.0})
+            for (bool cosmetic : {true, false})
+                for (Qt::PenCapStyle cap : {Qt::RoundCap, Qt::FlatCap, Qt::SquareCap})
+                    for (qreal progress : {0.004, 0.25, 0.5, 0.73, 1.0})
+                        for (qreal dpr : {1.0, 2.0}) {
+                            // The outline needs the ring's hole
+                            if (width * 3 >= size) continue;
+                            cases.append({size, width, cosmetic, cap, progress, dpr});
+                        }
+
+    // Straight into an image, the async raster and export path, against the
+    // exact outline and against QPainter
+    for (const Case &c : cases) {
+        QImage image = blank(c);
+        image.setDevicePixelRatio(c.dpr);
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.setPen(c.pen());
+        bool drawn = ArcRasterizer::drawArc(&painter, c.rect(), 90 * 16, c.spanAngle());
+        painter.end();
+        if (!drawn) {
+            ++count;
+            fail("image", c, "not drawn");
+            continue;
+        }
+        const QRegion all(image.rect());
+        check("image", c, difference(reference(c), image, blank(c), all));
+
+        const Difference diff = difference(stroked(c), image, blank(c), all);
+        const StrokerTolerance &allowed = c.deviceWidth() < 2 ? ThinStroker : WideStroker;
+        worstStroker = qMax(worstStroker, diff.max);
+        worstStrokerMean = qMax(worstStrokerMean, diff.mean);
+        if (diff.max > allowed.max || diff.mean > allowed.mean)
+            fail("stroker", c, QString("differs by %1, %2 on average").arg(diff.max).arg(diff.mean, 0, 'f', 1));
+    }
+
+    // Partial repaints of a widget: the left half of the ring and a small
+    // rect across its right side, where quarter turns end
+    CircularProgressRenderer::setArcBackend(CircularProgressRenderer::AnalyticArcs);
+    for (const Case &c : cases) {
+        if (c.size < 48 || c.progress < 0.25) continue;
+        const QRegion clip = QRegion(0, 0, c.size / 2, c.size)
+            + QRegion(c.size - int(c.width) - 4, c.size / 2 - 3, 8, 7);
+        QImage image = blank(c);
+        image.setDevicePixelRatio(c.dpr);
+        ArcWidget widget(c);
+        widget.render(&image, QPoint(), clip, QWidget::DrawChildren);
+        const QRegion deviceClip = QTransform::fromScale(c.dpr, c.dpr).map(clip);
+        check("clipped", c, difference(reference(c), image, blank(c), deviceClip));
+    }
+    CircularProgressRenderer::setArcBackend(CircularProgressRenderer::PathStroker);
+
+    log << count << " arcs, largest difference " << worst << " from the outline, " << worstStroker
+        << " from the stroker (mean " << QString::number(worstStrokerMean, 'f', 1) << "), "
+        << failures << " failed\n";
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,891 @@
+#include <cerrno>
+#include <cstdlib>
+#include <atomic>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QResizeEvent>
+#include <QTextStream>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+#include "arcrasterizer.h"
+#include "circularprogressbar.h"
+#include "circularprogressexporter.h"
+#include "progresssource.h"
+#include "progresstree.h"
+
+// Headless benchmark for CircularProgressBar.
+// Run with QT_QPA_PLATFORM=offscreen (the default when unset); results are
+// written as JSON so runs from different releases can be diffed.
+
+namespace {
+std::atomic<quint64> g_allocations{0};
+// Live heap bytes, only tracked on glibc
+std::atomic<qint64> g_heapBytes{0};
+}
+
+// Count heap allocations. On glibc malloc itself is wrapped so Qt's
+// container allocations are included, elsewhere only operator new is seen.
+#if defined(__GLIBC__)
+#include <malloc.h>
+
+#define HAVE_HEAP_BYTES
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void *__libc_valloc(size_t size);
+void *__libc_pvalloc(size_t size);
+void __libc_free(void *ptr);
+
+// Every block free() sees has to be counted here, aligned ones included,
+// or the live byte count drifts below zero
+static void *counted(void *ptr) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (ptr) g_heapBytes.fetch_add(malloc_usable_size(ptr), std::memory_order_relaxed);
+    return ptr;
+}
+
+void *malloc(size_t size) noexcept {
+    return counted(__libc_malloc(size));
+}
+
+void *calloc(size_t count, size_t size) noexcept {
+    return counted(__libc_calloc(count, size));
+}
+
+void *memalign(size_t alignment, size_t size) noexcept {
+    return counted(__libc_memalign(alignment, size));
+}
+
+void *aligned_alloc(size_t alignment, size_t size) noexcept {
+    return counted(__libc_memalign(alignment, size));
+}
+
+int posix_memalign(void **out, size_t alignment, size_t size) noexcept {
+    if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0) return EINVAL;
+    void *ptr = counted(__libc_memalign(alignment, size));
+    if (!ptr) return ENOMEM;
+    *out = ptr;
+    return 0;
+}
+
+void *valloc(size_t size) noexcept {
+    return counted(__libc_valloc(size));
+}
+
+void *pvalloc(size_t size) noexcept {
+    return counted(__libc_pvalloc(size));
+}
+
+void *realloc(void *ptr, size_t size) noexcept {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    qint64 previous = ptr ? qint64(malloc_usable_size(ptr)) : 0;
+    void *result = __libc_realloc(ptr, size);
+    if (result) g_heapBytes.fetch_add(qint64(malloc_usable_size(result)) - previous, std::memory_order_relaxed);
+    else if (size == 0) g_heapBytes.fetch_sub(previous, std::memory_order_relaxed);
+    return result;
+}
+
+void free(void *ptr) noexcept {
+    if (ptr) g_heapBytes.fetch_sub(malloc_usable_size(ptr), std::memory_order_relaxed);
+    __libc_free(ptr);
+}
+}
+#else
+void *operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+#endif
+
+namespace {
+
+struct BenchConfig {
+    int size = 200;
+    int progressWidth = 10;
+    bool gradient = false;
+    CircularProgressStyle::GradientMode gradientMode = CircularProgressStyle::LinearGradient;
+    bool text = true;
+    bool roundCap = true;
+    bool infinite = false;
+    int instances = 1;
+
+    QString name() const {
+        QString mode = gradient ? gradientModeName(gradientMode) : QString();
+        return QString("s%1_w%2_grad%3%4_text%5_round%6_%7_n%8")
+            .arg(size).arg(progressWidth)
+            .arg(int(gradient)).arg(mode == "linear" ? QString() : mode)
+            .arg(int(text)).arg(int(roundCap))
+            .arg(infinite ? "inf" : "det").arg(instances);
+    }
+
+    static QString gradientModeName(CircularProgressStyle::GradientMode mode) {
+        switch (mode) {
+        case CircularProgressStyle::ArcGradient: return "arc";
+        case CircularProgressStyle::FilledArcGradient: return "filled";
+        default: return "linear";
+        }
+    }
+};
+
+QList<int> parseIntList(const QString &value) {
+    QList<int> list;
+    for (const QString &part : value.split(',', Qt::SkipEmptyParts)) {
+        bool ok = false;
+        int number = part.trimmed().toInt(&ok);
+        if (ok && number > 0) list.append(number);
+    }
+    return list;
+}
+
+QMap<qreal, QColor> rainbowGradient() {
+    QMap<qreal, QColor> map;
+    map[0.0] = QColor(255, 0, 0);
+    map[0.2] = QColor(255, 127, 0);
+    map[0.4] = QColor(255, 255, 0);
+    map[0.6] = QColor(0, 255, 0);
+    map[0.8] = QColor(0, 0, 255);
+    map[1.0] = QColor(139, 0, 255);
+    return map;
+}
+
+void configureBar(CircularProgressBar *bar, const BenchConfig &config) {
+    bar->setGeometry(0, 0, config.size, config.size);
+    QResizeEvent resize(bar->size(), QSize());
+    QCoreApplication::sendEvent(bar, &resize);
+
+    bar->setProgressWidth(config.progressWidth);
+    bar->setGradientValues(rainbowGradient());
+    bar->setGradientMode(config.gradientMode);
+    bar->setGradient(config.gradient);
+    bar->setEnableText(config.text);
+    bar->setProgressRoundedCap(config.roundCap);
+    bar->setInfiniteLoop(config.infinite);
+}
+
+double percentile(const std::vector<double> &sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[qMin(index, sorted.size() - 1)];
+}
+
+QJsonObject runPaint(const BenchConfig &config, int frames) {
+    QWidget container;
+    std::vector<CircularProgressBar *> bars;
+    bars.reserve(config.instances);
+    for (int i = 0; i < config.instances; ++i) {
+        auto *bar = new CircularProgressBar(&container);
+        configureBar(bar, config);
+        bars.push_back(bar);
+    }
+
+    QImage target(config.size, config.size, QImage::Format_ARGB32_Premultiplied);
+    auto renderAll = [&]() {
+        for (CircularProgressBar *bar : bars)
+            bar->render(&target, QPoint(), QRegion(), QWidget::RenderFlags());
+    };
+
+    // Warm-up frame builds the caches so only steady-state frames are measured
+    target.fill(Qt::transparent);
+    renderAll();
+
+    std::vector<double> frameTimes;
+    frameTimes.reserve(frames);
+    quint64 allocations = 0;
+    QElapsedTimer timer;
+
+    for (int frame = 0; frame < frames; ++frame) {
+        for (CircularProgressBar *bar : bars) {
+            if (config.infinite)
+                bar->setProperty("startAngle", (frame * 6) % 360);
+            else
+                bar->setAnimationProgress(frames > 1 ? float(frame) / (frames - 1) : 0.5f);
+        }
+        target.fill(Qt::transparent);
+
+        quint64 allocBefore = g_allocations.load(std::memory_order_relaxed);
+        timer.start();
+        renderAll();
+        frameTimes.push_back(timer.nsecsElapsed() / 1000.0);
+        allocations += g_allocations.load(std::memory_order_relaxed) - allocBefore;
+    }
+
+    double total = 0.0;
+    for (double t : frameTimes) total += t;
+    std::sort(frameTimes.begin(), frameTimes.end());
+
+    QJsonObject paint;
+    paint["p50"] = percentile(frameTimes, 0.50);
+    paint["p90"] = percentile(frameTimes, 0.90);
+    paint["p99"] = percentile(frameTimes, 0.99);
+    paint["max"] = frameTimes.empty() ? 0.0 : frameTimes.back();
+    paint["mean"] = frameTimes.empty() ? 0.0 : total / frameTimes.size();
+    paint["mean_per_instance"] = frameTimes.empty() ? 0.0 : total / frameTimes.size() / config.instances;
+
+    QJsonObject result;
+    result["name"] = config.name();
+    result["size"] = config.size;
+    result["progress_width"] = config.progressWidth;
+    result["gradient"] = config.gradient;
+    result["gradient_mode"] = BenchConfig::gradientModeName(config.gradientMode);
+    result["text"] = config.text;
+    result["rounded_cap"] = config.roundCap;
+    result["infinite"] = config.infinite;
+    result["instances"] = config.instances;
+    result["frame_us"] = paint;
+    result["allocations_per_frame"] = frames > 0 ? double(allocations) / frames : 0.0;
+    return result;
+}
+
+// Exports a value sweep to PNG with one worker and with all of them
+QJsonObject runExport(int frames) {
+    QTemporaryDir dir;
+    QJsonObject result;
+    if (!dir.isValid()) return result;
+
+    CircularProgressTheme theme;
+    theme.setGradientColors(rainbowGradient());
+    theme.edit().gradient = true;
+    CircularProgressExporter exporter(theme);
+    exporter.setSize(QSize(200, 200));
+
+    QVector<qreal> values(frames);
+    for (int i = 0; i < frames; ++i) values[i] = frames > 1 ? qreal(i) / (frames - 1) : 0.5;
+
+    QThreadPool *pool = QThreadPool::globalInstance();
+    const int ideal = pool->maxThreadCount();
+    QJsonArray runs;
+    for (int threads : {1, ideal}) {
+        pool->setMaxThreadCount(threads);
+        QElapsedTimer timer;
+        timer.start();
+        int written = exporter.exportValues(values, dir.filePath("frame_%1.png"));
+        qint64 nsecs = qMax<qint64>(1, timer.nsecsElapsed());
+
+        QJsonObject run;
+        run["threads"] = threads;
+        run["frames"] = written;
+        run["frames_per_second"] = written * 1e9 / nsecs;
+        runs.append(run);
+        if (threads == ideal) break;
+    }
+    pool->setMaxThreadCount(ideal);
+
+    result["runs"] = runs;
+    return result;
+}
+
+// Generic drawFrame() against the variant framePainter() picks, on the same
+// frames, for a few typical configurations
+QJsonObject runFramePainters(int frames) {
+    struct Variant {
+        const char *name;
+        bool gradient;
+        CircularProgressStyle::GradientMode mode;
+        bool text;
+        bool roundCap;
+        bool infinite;
+    };
+    const Variant variants[] = {
+        {"solid_notext_flat", false, CircularProgressStyle::LinearGradient, false, false, false},
+        {"solid_text_round", false, CircularProgressStyle::LinearGradient, true, true, false},
+        {"linear_text_round", true, CircularProgressStyle::LinearGradient, true, true, false},
+        {"filled_text_round", true, CircularProgressStyle::FilledArcGradient, true, true, false},
+        {"spinner", false, CircularProgressStyle::LinearGradient, false, true, true},
+    };
+
+    const int rounds = qMax(1, frames) * 20;
+    QImage target(200, 200, QImage::Format_ARGB32_Premultiplied);
+    QJsonArray results;
+    for (const Variant &variant : variants) {
+        CircularProgressTheme theme;
+        theme.setGradientColors(rainbowGradient());
+        theme.edit().gradient = variant.gradient;
+        theme.edit().gradientMode = variant.mode;
+        theme.edit().textEnabled = variant.text;
+        theme.edit().roundedCap = variant.roundCap;
+        const CircularProgressStyle &style = theme.style();
+
+        QRect rect = CircularProgressRenderer::ringRect(target.rect(), style);
+        QPen progressPen = CircularProgressRenderer::progressPen(style, rect);
+        QPen highlightPen = CircularProgressRenderer::highlightPen(style);
+        CircularProgressLabelCache labels;
+        CircularProgressRenderer::FramePainter painter =
+            CircularProgressRenderer::framePainter(style, progressPen, highlightPen, variant.infinite);
+
+        auto measure = [&](bool specialized) {
+            QPainter p(&target);
+            p.setRenderHints(QPainter::Antialiasing);
+            QElapsedTimer timer;
+            timer.start();
+            for (int i = 0; i < rounds; ++i) {
+                qreal progress = qreal(i % 101) / 100;
+                int angle = (i * 6) % 360;
+                const QStaticText *label = style.textEnabled && !variant.infinite
+                    ? &labels.label(int(progress * 100), style.suffix, QFont()) : nullptr;
+                if (specialized) {
+                    CircularProgressFrame frame;
+                    frame.ringRect = rect;
+                    frame.style = &style;
+                    frame.progressPen = &progressPen;
+                    frame.highlightPen = &highlightPen;
+                    frame.progress = progress;
+                    frame.startAngle = angle;
+                    frame.label = label;
+                    painter(&p, frame);
+                } else {
+                    CircularProgressRenderer::drawFrame(&p, rect, style, progressPen, highlightPen,
+                                                        progress, angle, variant.infinite, label);
+                }
+            }
+            return timer.nsecsElapsed() / 1e3 / rounds;
+        };
+
+        measure(false);  // warm-up: glyphs and gradient caches
+        QJsonObject result;
+        result["name"] = variant.name;
+        result["generic_us"] = measure(false);
+        result["specialized_us"] = measure(true);
+        results.append(result);
+    }
+    return QJsonObject{{"frames", rounds}, {"variants", results}};
+}
+
+// Pen and arc of one ring per frame with a solid color and with a gradient
+// stretched over the filled part. The first filled sweep builds the brushes,
+// the second one finds them cached.
+QJsonObject runFilledArc(int frames) {
+    const int rounds = qMax(1, frames) * 20;
+    QImage target(200, 200, QImage::Format_ARGB32_Premultiplied);
+    CircularProgressTheme theme;
+    theme.setGradientColors(rainbowGradient());
+    theme.edit().roundedCap = true;
+
+    auto measure = [&](bool filled) {
+        theme.edit().gradient = filled;
+        theme.edit().gradientMode = CircularProgressStyle::FilledArcGradient;
+        const CircularProgressStyle &style = theme.style();
+        QRect rect = CircularProgressRenderer::ringRect(target.rect(), style);
+        QPen solidPen = CircularProgressRenderer::progressPen(style, rect);
+
+        QPainter painter(&target);
+        painter.setRenderHints(QPainter::Antialiasing);
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < rounds; ++i) {
+            qreal progress = qreal(i + 1) / rounds;
+            QPen pen = filled ? CircularProgressRenderer::progressPen(style, rect, progress * style.circularDegree, 1.0)
+                              : solidPen;
+            CircularProgressRenderer::drawProgress(&painter, rect, pen, progress, style.circularDegree);
+        }
+        return timer.nsecsElapsed() / 1e3 / rounds;
+    };
+
+    QJsonObject result;
+    result["frames"] = rounds;
+    result["solid_us"] = measure(false);
+    result["filled_first_us"] = measure(true);
+    result["filled_cached_us"] = measure(true);
+    return result;
+}
+
+// Track and solid arc of one ring per frame, stroked by QPainter and by the
+// analytic rasterizer
+QJsonObject runArcBackends(int frames) {
+    const int rounds = qMax(1, frames) * 20;
+    QJsonArray results;
+    for (int size : {48, 200, 400}) {
+        for (int width : {4, 16}) {
+            for (bool roundCap : {false, true}) {
+                CircularProgressStyle style;
+                style.progressWidth = width;
+                style.roundedCap = roundCap;
+                QImage target(size, size, QImage::Format_ARGB32_Premultiplied);
+                QRect rect = CircularProgressRenderer::ringRect(target.rect(), style);
+                QPen pen = CircularProgressRenderer::progressPen(style, rect);
+
+                auto measure = [&](CircularProgressRenderer::ArcBackend backend) {
+                    CircularProgressRenderer::setArcBackend(backend);
+                    QPainter p(&target);
+                    p.setRenderHints(QPainter::Antialiasing);
+                    QElapsedTimer timer;
+                    timer.start();
+                    for (int i = 0; i < rounds; ++i) {
+                        CircularProgressRenderer::drawTrack(&p, rect, style);
+                        CircularProgressRenderer::drawProgress(&p, rect, pen, qreal(i % 101) / 100, style.circularDegree);
+                    }
+                    return timer.nsecsElapsed() / 1e3 / rounds;
+                };
+
+                measure(CircularProgressRenderer::PathStroker);  // warm-up
+                QJsonObject result;
+                result["size"] = size;
+                result["width"] = width;
+                result["round_cap"] = roundCap;
+                result["stroker_us"] = measure(CircularProgressRenderer::PathStroker);
+                result["analytic_us"] = measure(CircularProgressRenderer::AnalyticArcs);
+                results.append(result);
+            }
+        }
+    }
+    CircularProgressRenderer::setArcBackend(CircularProgressRenderer::PathStroker);
+    return QJsonObject{{"frames", rounds}, {"sse2", ArcRasterizer::isVectorized()}, {"runs", results}};
+}
+
+// Render cost of a dashboard of small gradient rings pinned at each quality level
+QJsonObject runQualityLevels(int count, int frames) {
+    QWidget container;
+    std::vector<CircularProgressBar *> bars;
+    for (int i = 0; i < count; ++i) {
+        auto *bar = new CircularProgressBar(&container);
+        bar->setGeometry(0, 0, 48, 48);
+        bar->setGradientValues(rainbowGradient());
+        bar->setGradientMode(CircularProgressStyle::ArcGradient);
+        bar->setGradient(true);
+        bars.push_back(bar);
+    }
+
+    QImage target(48, 48, QImage::Format_ARGB32_Premultiplied);
+    QJsonArray levels;
+    for (int level = 0; level < ProgressQualityGovernor::LevelCount; ++level) {
+        for (CircularProgressBar *bar : bars) {
+            bar->setQualityLevel(level);
+            bar->render(&target, QPoint(), QRegion(), QWidget::RenderFlags());
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        for (int frame = 0; frame < frames; ++frame) {
+            for (CircularProgressBar *bar : bars) {
+                bar->setAnimationProgress(frames > 1 ? float(frame) / (frames - 1) : 0.5f);
+                bar->render(&target, QPoint(), QRegion(), QWidget::RenderFlags());
+            }
+        }
+
+        QJsonObject result;
+        result["level"] = level;
+        result["frame_us"] = timer.nsecsElapsed() / 1e3 / frames;
+        levels.append(result);
+    }
+
+    QJsonObject result;
+    result["count"] = count;
+    result["levels"] = levels;
+    return result;
+}
+
+// Animated rings with and without a shadow. The blur happens when the layer is
+// built, so the difference in frame time is the cost of compositing it.
+QJsonObject runShadow(int count, int frames) {
+    QJsonObject result;
+    result["count"] = count;
+    for (bool shadow : {false, true}) {
+        QWidget container;
+        std::vector<CircularProgressBar *> bars;
+        for (int i = 0; i < count; ++i) {
+            auto *bar = new CircularProgressBar(&container);
+            bar->setGeometry(0, 0, 96, 96);
+            bar->setShadow(shadow);
+            bars.push_back(bar);
+        }
+
+        QImage target(96, 96, QImage::Format_ARGB32_Premultiplied);
+        QElapsedTimer timer;
+        timer.start();
+        for (CircularProgressBar *bar : bars) bar->render(&target, QPoint(), QRegion(), QWidget::RenderFlags());
+        double buildUs = timer.nsecsElapsed() / 1e3 / count;
+
+        timer.start();
+        for (int frame = 0; frame < frames; ++frame) {
+            for (CircularProgressBar *bar : bars) {
+                bar->setAnimationProgress(frames > 1 ? float(frame) / (frames - 1) : 0.5f);
+                bar->render(&target, QPoint(), QRegion(), QWidget::RenderFlags());
+            }
+        }
+
+        QJsonObject run;
+        run["layer_build_us"] = buildUs;
+        run["frame_us"] = timer.nsecsElapsed() / 1e3 / frames;
+        result[shadow ? "shadow" : "plain"] = run;
+    }
+    return result;
+}
+
+// Event loop responsiveness of a shown dashboard of count rings with
+// animating of them spinning. A 5 ms probe timer stands in for input events;
+// its lateness is how long the GUI thread was busy painting.
+QJsonObject runInputLatency(int count, int animating, bool async, int msec) {
+    QWidget container;
+    const int columns = 20, side = 48;
+    container.resize(columns * side, (count + columns - 1) / columns * side);
+    for (int i = 0; i < count; ++i) {
+        auto *bar = new CircularProgressBar(&container);
+        bar->setGeometry(i % columns * side, i / columns * side, side, side);
+        bar->setGradientValues(rainbowGradient());
+        bar->setGradient(true);
+        bar->setAsyncRaster(async);
+        bar->setInfiniteLoop(i < animating);
+        bar->setValue(i % 100);
+    }
+    container.show();
+    QCoreApplication::processEvents();
+
+    std::vector<double> lateness;
+    QElapsedTimer clock;
+    QTimer probe;
+    probe.setTimerType(Qt::PreciseTimer);
+    probe.setInterval(5);
+    QObject::connect(&probe, &QTimer::timeout, [&]() {
+        lateness.push_back(qMax(0.0, clock.nsecsElapsed() / 1e6 - probe.interval()));
+        clock.restart();
+    });
+
+    QEventLoop loop;
+    QTimer::singleShot(msec, &loop, &QEventLoop::quit);
+    clock.start();
+    probe.start();
+    loop.exec();
+    probe.stop();
+
+    std::sort(lateness.begin(), lateness.end());
+    QJsonObject result;
+    result["count"] = count;
+    result["animating"] = animating;
+    result["async"] = async;
+    result["probes"] = int(lateness.size());
+    result["late_ms_p50"] = percentile(lateness, 0.50);
+    result["late_ms_p99"] = percentile(lateness, 0.99);
+    result["late_ms_max"] = lateness.empty() ? 0.0 : lateness.back();
+    return result;
+}
+
+// A producer thread counts through a shared file mapping as fast as it can
+// while a shown bar samples it once per driver frame
+QJsonObject runSharedSource(int frames) {
+    QTemporaryDir dir;
+    QJsonObject result;
+    SharedProgressSource producer, consumer;
+    if (!dir.isValid() || !producer.createFile(dir.filePath("progress")) || !consumer.mapFile(dir.filePath("progress")))
+        return result;
+    producer.setTotal(quint64(1) << 40);
+
+    CircularProgressBar bar;
+    bar.resize(100, 100);
+    bar.setProgressSource(&consumer);
+    bar.show();
+    QCoreApplication::processEvents();
+
+    std::atomic<bool> running{true};
+    std::thread thread([&]() {
+        while (running.load(std::memory_order_relaxed)) producer.add();
+    });
+
+    ProgressAnimationDriver *driver = ProgressAnimationDriver::instance();
+    QElapsedTimer timer;
+    qint64 sampleNsecs = 0;
+    timer.start();
+    for (int frame = 0; frame < frames; ++frame) {
+        QElapsedTimer sample;
+        sample.start();
+        driver->processFrame();
+        sampleNsecs += sample.nsecsElapsed();
+        QCoreApplication::processEvents();
+    }
+    qint64 nsecs = qMax<qint64>(1, timer.nsecsElapsed());
+    running = false;
+    thread.join();
+
+    result["frames"] = frames;
+    result["producer_updates_per_second"] = producer.current() * 1e9 / nsecs;
+    result["frame_us"] = sampleNsecs / 1e3 / frames;
+    result["value"] = bar.value();
+    result["maximum"] = bar.maximum();
+    return result;
+}
+
+// Weighted tree of groups x leaves, every leaf stepped to completion by
+// worker threads working on disjoint leaves
+QJsonObject runProgressTree(int groups, int leaves, int steps) {
+    ProgressTree tree;
+    tree.reserve(1 + groups * (leaves + 1));
+    std::vector<ProgressTree::NodeId> ids;
+    ids.reserve(size_t(groups) * leaves);
+    for (int g = 0; g < groups; ++g) {
+        ProgressTree::NodeId group = tree.addNode(ProgressTree::Root, 1 + g % 7);
+        for (int l = 0; l < leaves; ++l) ids.push_back(tree.addNode(group, 1 + l % 3));
+    }
+
+    const int threads = qMax(1, QThread::idealThreadCount());
+    std::vector<std::thread> workers;
+    QElapsedTimer timer;
+    timer.start();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            for (int step = 1; step <= steps; ++step) {
+                for (size_t i = t; i < ids.size(); i += threads)
+                    tree.setProgress(ids[i], quint64(step), quint64(steps));
+            }
+        });
+    }
+    for (std::thread &worker : workers) worker.join();
+    qint64 nsecs = qMax<qint64>(1, timer.nsecsElapsed());
+
+    quint64 current = 0, total = 0;
+    tree.sample(&current, &total);
+    int value = 0, maximum = 0;
+    ProgressSource::mapToRange(current, total, &value, &maximum);
+
+    QJsonObject result;
+    result["nodes"] = tree.nodeCount();
+    result["threads"] = threads;
+    result["updates_per_second"] = double(ids.size()) * steps * 1e9 / nsecs;
+    result["complete"] = current == total && value == maximum;
+    return result;
+}
+
+// Constructs and destroys count bars, reporting time and heap per instance
+QJsonObject runConstruction(int count) {
+    auto container = std::make_unique<QWidget>();
+    std::vector<CircularProgressBar *> bars;
+    bars.reserve(count);
+
+    qint64 heapBefore = g_heapBytes.load(std::memory_order_relaxed);
+    quint64 allocBefore = g_allocations.load(std::memory_order_relaxed);
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < count; ++i)
+        bars.push_back(new CircularProgressBar(container.get()));
+    qint64 constructNsecs = timer.nsecsElapsed();
+    qint64 heap = g_heapBytes.load(std::memory_order_relaxed) - heapBefore;
+    quint64 allocations = g_allocations.load(std::memory_order_relaxed) - allocBefore;
+
+    timer.restart();
+    container.reset();
+    qint64 destroyNsecs = timer.nsecsElapsed();
+
+    QJsonObject result;
+    result["count"] = count;
+    result["construct_ms"] = constructNsecs / 1e6;
+    result["construct_us_per_instance"] = constructNsecs / 1e3 / count;
+    result["destroy_ms"] = destroyNsecs / 1e6;
+    result["allocations_per_instance"] = double(allocations) / count;
+#ifdef HAVE_HEAP_BYTES
+    result["heap_bytes"] = double(heap);
+    result["heap_bytes_per_instance"] = double(heap) / count;
+#else
+    Q_UNUSED(heap);
+#endif
+    result["sizeof"] = int(sizeof(CircularProgressBar));
+    return result;
+}
+
+// Restyles a dashboard of bars with the individual setters and with one
+// shared theme, each followed by a render so deferred updates are paid for
+QJsonObject runThemeSwitch(int count) {
+    QWidget container;
+    std::vector<CircularProgressBar *> bars;
+    for (int i = 0; i < count; ++i) {
+        auto *bar = new CircularProgressBar(&container);
+        bar->setGeometry(0, 0, 100, 100);
+        bars.push_back(bar);
+    }
+
+    QImage target(100, 100, QImage::Format_ARGB32_Premultiplied);
+    auto measure = [&](const std::function<void(CircularProgressBar *, int)> &apply) {
+        QElapsedTimer timer;
+        quint64 allocBefore = g_allocations.load(std::memory_order_relaxed);
+        timer.start();
+        for (int round = 0; round < 2; ++round) {
+            for (CircularProgressBar *bar : bars) {
+                apply(bar, round);
+                bar->render(&target, QPoint(), QRegion(), QWidget::RenderFlags());
+            }
+        }
+        QJsonObject result;
+        result["ms"] = timer.nsecsElapsed() / 2e6;
+        result["allocations"] = double(g_allocations.load(std::memory_order_relaxed) - allocBefore) / 2;
+        return result;
+    };
+
+    CircularProgressTheme themes[2];
+    themes[0].setGradientColors(rainbowGradient());
+    themes[0].edit().gradient = true;
+    themes[0].edit().progressWidth = 12;
+    themes[1].edit().chunkColor = QColor(230, 126, 34);
+    themes[1].edit().backgroundColor = QColor(40, 40, 40);
+    themes[1].edit().roundedCap = false;
+
+    QJsonObject result;
+    result["count"] = count;
+    result["setters"] = measure([&](CircularProgressBar *bar, int round) {
+        const CircularProgressStyle &style = themes[round].style();
+        bar->beginStyleUpdate();
+        bar->setGradientValues(style.gradientColors);
+        bar->setGradient(style.gradient);
+        bar->setProgressWidth(style.progressWidth);
+        bar->setProgressRoundedCap(style.roundedCap);
+        bar->setChunkColor(style.chunkColor);
+        bar->setBgColor(style.backgroundColor);
+        bar->endStyleUpdate();
+    });
+    result["shared_theme"] = measure([&](CircularProgressBar *bar, int round) {
+        bar->setTheme(themes[round]);
+    });
+    return result;
+}
+
+QJsonObject runValueUpdates(int count, ProgressValueAnimation::Mode mode) {
+    CircularProgressBar bar;
+    bar.setRange(0, 1000);
+    bar.setAnimationMode(mode);
+
+    quint64 allocBefore = g_allocations.load(std::memory_order_relaxed);
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < count; ++i)
+        bar.setValue(i % 1001);
+    qint64 nsecs = qMax<qint64>(1, timer.nsecsElapsed());
+    quint64 allocations = g_allocations.load(std::memory_order_relaxed) - allocBefore;
+
+    QJsonObject result;
+    result["count"] = count;
+    result["per_second"] = count * 1e9 / nsecs;
+    result["allocations_per_update"] = count > 0 ? double(allocations) / count : 0.0;
+    return result;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+    QApplication::setApplicationName("CircularProgressBenchmark");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Paint and animation benchmark for CircularProgressBar");
+    parser.addHelpOption();
+    QCommandLineOption framesOption("frames", "Measured frames per configuration.", "n", "30");
+    QCommandLineOption sizesOption("sizes", "Comma separated ring sizes.", "list", "48,200,400");
+    QCommandLineOption widthsOption("widths", "Comma separated progress widths.", "list", "4,16");
+    QCommandLineOption instancesOption("instances", "Comma separated instance counts.", "list", "1,100,1000");
+    QCommandLineOption updatesOption("updates", "setValue() calls for the throughput test.", "n", "200000");
+    QCommandLineOption gradientModeOption("gradient-mode", "Gradient layout: linear, arc or filled.", "mode", "linear");
+    QCommandLineOption constructOption("construct", "Bars built for the construction and memory test.", "n", "10000");
+    QCommandLineOption exportOption("export-frames", "Frames for the PNG export test, 0 skips it.", "n", "120");
+    QCommandLineOption latencyOption("latency-ms", "Duration of each input latency run, 0 skips them.", "msec", "1000");
+    QCommandLineOption filterOption("filter", "Only run configurations whose name contains this text.", "text");
+    QCommandLineOption outputOption({"o", "output"}, "Write JSON results to this file instead of stdout.", "file");
+    parser.addOptions({framesOption, sizesOption, widthsOption, instancesOption,
+                       updatesOption, constructOption, exportOption, latencyOption,
+                       gradientModeOption, filterOption, outputOption});
+    parser.process(app);
+
+    const int frames = qMax(1, parser.value(framesOption).toInt());
+    const QList<int> sizes = parseIntList(parser.value(sizesOption));
+    const QList<int> widths = parseIntList(parser.value(widthsOption));
+    const QList<int> instances = parseIntList(parser.value(instancesOption));
+    const QString filter = parser.value(filterOption);
+    CircularProgressStyle::GradientMode gradientMode = CircularProgressStyle::LinearGradient;
+    if (parser.value(gradientModeOption) == "arc") gradientMode = CircularProgressStyle::ArcGradient;
+    else if (parser.value(gradientModeOption) == "filled") gradientMode = CircularProgressStyle::FilledArcGradient;
+
+    QTextStream log(stderr);
+    QJsonArray results;
+
+    for (int count : instances) {
+        for (int size : sizes) {
+            for (int width : widths) {
+                for (int flags = 0; flags < 8; ++flags) {
+                    for (bool infinite : {false, true}) {
+                        BenchConfig config;
+                        config.size = size;
+                        config.progressWidth = width;
+                        config.gradient = flags & 1;
+                        config.gradientMode = gradientMode;
+                        config.text = flags & 2;
+                        config.roundCap = flags & 4;
+                        config.infinite = infinite;
+                        config.instances = count;
+                        // Text only matters for determinate bars
+                        if (infinite && config.text) continue;
+                        if (!filter.isEmpty() && !config.name().contains(filter)) continue;
+
+                        QJsonObject result = runPaint(config, frames);
+                        QJsonObject paint = result["frame_us"].toObject();
+                        log << config.name() << ": p50 " << paint["p50"].toDouble()
+                            << " us, p99 " << paint["p99"].toDouble() << " us, "
+                            << result["allocations_per_frame"].toDouble() << " allocs/frame\n";
+                        log.flush();
+                        results.append(result);
+                    }
+                }
+            }
+        }
+    }
+
+    QJsonObject report;
+    report["qt_version"] = QString(qVersion());
+    report["platform"] = QGuiApplication::platformName();
+    report["frames"] = frames;
+    report["paint"] = results;
+    const int updates = qMax(1, parser.value(updatesOption).toInt());
+    report["value_updates"] = runValueUpdates(updates, ProgressValueAnimation::Eased);
+    report["value_updates_spring"] = runValueUpdates(updates, ProgressValueAnimation::Spring);
+    report["theme_switch"] = runThemeSwitch(400);
+    report["quality_levels"] = runQualityLevels(100, frames);
+    report["shadow"] = runShadow(100, frames);
+    report["frame_painters"] = runFramePainters(frames);
+    report["filled_arc"] = runFilledArc(frames);
+    report["arc_backends"] = runArcBackends(frames);
+    report["shared_source"] = runSharedSource(frames);
+    report["progress_tree"] = runProgressTree(200, 1000, 10);
+    report["construction"] = runConstruction(qMax(1, parser.value(constructOption).toInt()));
+    if (parser.value(exportOption).toInt() > 0)
+        report["export"] = runExport(parser.value(exportOption).toInt());
+
+    if (parser.value(latencyOption).toInt() > 0) {
+        QJsonArray latency;
+        for (bool async : {false, true}) {
+            for (int animating : {0, 100, 400})
+                latency.append(runInputLatency(400, animating, async, parser.value(latencyOption).toInt()));
+        }
+        report["input_latency"] = latency;
+    }
+
+    QByteArray json = QJsonDocument(report).toJson();
+    if (parser.isSet(outputOption)) {
+        QFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qWarning() << "Cannot write" << file.fileName();
+            return 1;
+        }
+        file.write(json);
+    } else {
+        QTextStream(stdout) << json;
+    }
+    return 0;
+}
@@ -0,0 +1,362 @@
+#include "circularmultiprogress.h"
+#include "circularprogressbar.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+QPointF arcPoint(const QRectF &rect, qreal angle) {
+    qreal rad = qDegreesToRadians(angle);
+    return QPointF(rect.center().x() + rect.width() / 2 * qSin(rad),
+                   rect.center().y() - rect.height() / 2 * qCos(rad));
+}
+
+// Bounds of an arc from its end points and the extremes it passes
+QRect arcBounds(const QRect &rect, qreal start, qreal span, int pad) {
+    QRectF arcRect(rect);
+    QPointF first = arcPoint(arcRect, start);
+    QRectF bounds(first, first);
+    auto include = [&](const QPointF &point) {
+        bounds.setLeft(qMin(bounds.left(), point.x()));
+        bounds.setRight(qMax(bounds.right(), point.x()));
+        bounds.setTop(qMin(bounds.top(), point.y()));
+        bounds.setBottom(qMax(bounds.bottom(), point.y()));
+    };
+
+    include(arcPoint(arcRect, start + span));
+    for (qreal extreme = std::ceil(start / 90.0) * 90.0; extreme < start + span; extreme += 90.0)
+        include(arcPoint(arcRect, extreme));
+
+    return bounds.toAlignedRect().adjusted(-pad, -pad, pad, pad);
+}
+
+}
+
+CircularMultiProgress::CircularMultiProgress(QWidget *parent) : QWidget(parent) {
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+    setMinimumSize(50, 50);
+    m_animation.setEasingCurve(QEasingCurve(QEasingCurve::OutCubic));
+    m_animation.setDuration(m_duration);
+}
+
+CircularMultiProgress::~CircularMultiProgress() {
+    if (m_registered) ProgressAnimationDriver::instance()->unregisterClient(this);
+}
+
+void CircularMultiProgress::setRingLayout(RingLayout layout) {
+    if (m_layout == layout) return;
+
+    m_layout = layout;
+    invalidateStaticLayer();
+}
+
+void CircularMultiProgress::setRingCount(int count) {
+    count = qMax(0, count);
+    const int previous = ringCount();
+    if (count == previous) return;
+
+    // Rings that stay keep animating, added ones start empty
+    m_target.resize(count);
+    m_current.resize(count);
+    m_animations.resize(count);
+    for (int i = previous; i < count; ++i) {
+        m_target[i] = m_current[i] = 0.0f;
+        m_animations[i] = m_animation;
+    }
+    m_active.erase(std::remove_if(m_active.begin(), m_active.end(), [count](int index) { return index >= count; }),
+                   m_active.end());
+    updateScheduling();
+    invalidateStaticLayer();
+}
+
+void CircularMultiProgress::setValues(const float *values, int count) {
+    if (count != ringCount()) setRingCount(count);
+
+    QRegion dirty;
+    bool animate = m_duration > 0 && CircularProgressBar::isAnimationVisible(this);
+    for (int i = 0; i < count; ++i) applyValue(i, values[i], animate, &dirty);
+
+    if (!dirty.isEmpty()) update(dirty);
+    updateScheduling();
+}
+
+void CircularMultiProgress::setValue(int index, float value) {
+    if (index < 0 || index >= ringCount()) return;
+
+    QRegion dirty;
+    applyValue(index, value, m_duration > 0 && CircularProgressBar::isAnimationVisible(this), &dirty);
+    if (!dirty.isEmpty()) update(dirty);
+    updateScheduling();
+}
+
+void CircularMultiProgress::applyValue(int index, float value, bool animate, QRegion *dirty) {
+    value = qBound(0.0f, value, 1.0f);
+    if (value == m_target[index]) return;
+
+    m_target[index] = value;
+    ProgressValueAnimation &animation = m_animations[index];
+    if (animate) {
+        if (!animation.isRunning()) m_active.append(index);
+        animation.start(m_current[index], value);
+    } else {
+        animation.stop();
+        m_current[index] = value;
+        *dirty += dirtyRect(index);
+    }
+}
+
+void CircularMultiProgress::setTheme(const CircularProgressTheme &theme) {
+    if (m_theme.isSharedWith(theme)) return;
+
+    m_theme = theme;
+    invalidateStaticLayer();
+}
+
+void CircularMultiProgress::setRingSpacing(int spacing) {
+    m_ringSpacing = qMax(0, spacing);
+    invalidateStaticLayer();
+}
+
+void CircularMultiProgress::setSegmentGap(qreal degrees) {
+    m_segmentGap = qMax<qreal>(0, degrees);
+    invalidateStaticLayer();
+}
+
+void CircularMultiProgress::setAnimationDuration(int msec) {
+    m_duration = qMax(0, msec);
+    m_animation.setDuration(m_duration);
+    for (ProgressValueAnimation &animation : m_animations) animation.setDuration(m_duration);
+    if (m_duration == 0) finishAnimations();
+}
+
+void CircularMultiProgress::setEasingCurve(const QEasingCurve &curve) {
+    m_animation.setEasingCurve(curve);
+    for (ProgressValueAnimation &animation : m_animations) animation.setEasingCurve(curve);
+}
+
+void CircularMultiProgress::setAnimationMode(ProgressValueAnimation::Mode mode) {
+    if (mode == m_animation.mode()) return;
+
+    // Running rings continue from where they are now in the new mode
+    m_animation.setMode(mode);
+    for (int i = 0; i < m_animations.size(); ++i) {
+        ProgressValueAnimation &animation = m_animations[i];
+        bool running = animation.isRunning();
+        animation.setMode(mode);
+        if (running) animation.start(m_current[i], m_target[i]);
+    }
+}
+
+void CircularMultiProgress::setSpringResponse(int msec) {
+    m_animation.setSpringResponse(msec);
+    for (ProgressValueAnimation &animation : m_animations) animation.setSpringResponse(msec);
+}
+
+QSize CircularMultiProgress::sizeHint() const {
+    return QSize(200, 200);
+}
+
+void CircularMultiProgress::updateScheduling() {
+    // Paused rings keep their animation state and resume where they stopped
+    bool needsTicks = !m_active.isEmpty() && CircularProgressBar::isAnimationVisible(this);
+    if (needsTicks == m_registered) return;
+
+    ProgressAnimationDriver *driver = ProgressAnimationDriver::instance();
+    m_registered = needsTicks;
+    if (m_registered) {
+        m_lastFrameTime = driver->elapsed();
+        driver->registerClient(this);
+    } else {
+        driver->unregisterClient(this);
+    }
+}
+
+void CircularMultiProgress::finishAnimations() {
+    for (int index : std::as_const(m_active)) {
+        m_current[index] = m_target[index];
+        m_animations[index].stop();
+    }
+    m_active.clear();
+    updateScheduling();
+    update();
+}
+
+void CircularMultiProgress::advanceAnimation(qint64 frameTime) {
+    qint64 delta = qMax<qint64>(0, frameTime - m_lastFrameTime);
+    m_lastFrameTime = frameTime;
+
+    // Only rings with a pending change are advanced and repainted
+    QRegion dirty;
+    int kept = 0;
+    for (int index : std::as_const(m_active)) {
+        ProgressValueAnimation &animation = m_animations[index];
+        m_current[index] = animation.advance(delta);
+        dirty += dirtyRect(index);
+        if (animation.isRunning()) m_active[kept++] = index;
+    }
+    m_active.resize(kept);
+
+    if (!dirty.isEmpty()) update(dirty);
+    if (m_active.isEmpty()) updateScheduling();
+}
+
+QRect CircularMultiProgress::ringBounds() const {
+    int side = qMin(width(), height());
+    QRect bounds(0, 0, side, side);
+    bounds.moveCenter(rect().center());
+    return bounds;
+}
+
+void CircularMultiProgress::ringArc(int index, QRect *rect, qreal *start, qreal *span) const {
+    const CircularProgressStyle &style = m_theme.style();
+    QRect bounds = ringBounds();
+
+    if (m_layout == Concentric) {
+        int inset = index * (style.progressWidth + m_ringSpacing);
+        *rect = CircularProgressRenderer::ringRect(bounds.adjusted(inset, inset, -inset, -inset), style);
+        *start = 0;
+        *span = style.circularDegree;
+        return;
+    }
+
+    // A full circle needs a gap after the last segment as well
+    int count = qMax(1, ringCount());
+    int gaps = style.circularDegree >= 360 ? count : count - 1;
+    qreal segment = qMax<qreal>(0, (style.circularDegree - gaps * m_segmentGap) / count);
+    *rect = CircularProgressRenderer::ringRect(bounds, style);
+    *start = index * (segment + m_segmentGap);
+    *span = segment;
+}
+
+QRect CircularMultiProgress::dirtyRect(int index) const {
+    QRect rect;
+    qreal start = 0, span = 0;
+    ringArc(index, &rect, &start, &span);
+
+    // Half the pen plus square caps and antialiasing
+    int pad = qCeil(m_theme->progressWidth * 0.75) + 2;
+    return arcBounds(rect, start, span, pad);
+}
+
+void CircularMultiProgress::invalidateStaticLayer() {
+    m_staticLayerDirty = true;
+    update();
+}
+
+void CircularMultiProgress::ensureStaticLayer() {
+    qreal dpr = devicePixelRatioF();
+    if (!m_staticLayerDirty && m_staticLayerSize == size() && qFuzzyCompare(m_staticLayerDpr, dpr))
+        return;
+
+    m_staticLayerDirty = false;
+    m_staticLayerSize = size();
+    m_staticLayerDpr = dpr;
+    const CircularProgressStyle &style = m_theme.style();
+
+    // Concentric rings share one center, so the outermost ring's pen (and
+    // its gradient texture) serves every ring
+    QRect outer = CircularProgressRenderer::ringRect(ringBounds(), style);
+    m_progressPen = CircularProgressRenderer::progressPen(style, outer, dpr);
+    m_highlightPen = CircularProgressRenderer::highlightPen(style);
+
+    if (!style.backgroundEnabled || size().isEmpty()) {
+        m_staticLayer = QPixmap();
+        return;
+    }
+
+    m_staticLayer = QPixmap(size() * dpr);
+    m_staticLayer.setDevicePixelRatio(dpr);
+    m_staticLayer.fill(Qt::transparent);
+
+    QPainter layer(&m_staticLayer);
+    layer.setRenderHints(QPainter::Antialiasing);
+    const QPen trackPen = CircularProgressRenderer::trackPen(style);
+    for (int i = 0; i < ringCount(); ++i) {
+        QRect rect;
+        qreal start = 0, span = 0;
+        ringArc(i, &rect, &start, &span);
+        if (rect.width() > 0 && rect.height() > 0)
+            CircularProgressRenderer::drawArc(&layer, rect, trackPen, start, span);
+    }
+}
+
+void CircularMultiProgress::paintEvent(QPaintEvent *event) {
+    ensureStaticLayer();
+
+    QPainter painter(this);
+    painter.setRenderHints(QPainter::Antialiasing);
+    if (!m_staticLayer.isNull()) painter.drawPixmap(0, 0, m_staticLayer);
+
+    const CircularProgressStyle &style = m_theme.style();
+    // Stretched gradients start at 12 o'clock, which only fits whole rings
+    bool filledGradient = m_layout == Concentric && style.gradient
+                          && style.gradientMode == CircularProgressStyle::FilledArcGradient;
+    const QRegion &region = event->region();
+
+    for (int i = 0; i < ringCount(); ++i) {
+        float value = m_current[i];
+        if (value <= 0.0f) continue;
+
+        QRect rect;
+        qreal start = 0, span = 0;
+        ringArc(i, &rect, &start, &span);
+        if (rect.width() <= 0 || rect.height() <= 0) continue;
+        if (m_layout == Segmented && !region.intersects(dirtyRect(i))) continue;
+
+        QPen pen = m_progressPen;
+        if (value > style.highlightThreshold) pen = m_highlightPen;
+        else if (filledGradient) pen = CircularProgressRenderer::progressPen(style, rect, value * span, m_staticLayerDpr);
+        CircularProgressRenderer::drawArc(&painter, rect, pen, start, value * span);
+    }
+}
+
+void CircularMultiProgress::resizeEvent(QResizeEvent *event) {
+    QWidget::resizeEvent(event);
+    invalidateStaticLayer();
+}
+
+void CircularMultiProgress::watchWindow() {
+    QWidget *top = window();
+    if (top != m_watchedWindow) {
+        if (m_watchedWindow) m_watchedWindow->removeEventFilter(this);
+        m_watchedWindow = top;
+        // The widget may be the window itself; its own events already reach changeEvent()
+        if (top != this) top->installEventFilter(this);
+    }
+
+    QWindow *handle = top->windowHandle();
+    if (handle != m_watchedHandle) {
+        if (m_watchedHandle) m_watchedHandle->removeEventFilter(this);
+        m_watchedHandle = handle;
+        if (handle) handle->installEventFilter(this);
+    }
+}
+
+void CircularMultiProgress::showEvent(QShowEvent *event) {
+    QWidget::showEvent(event);
+    watchWindow();
+    updateScheduling();
+}
+
+void CircularMultiProgress::hideEvent(QHideEvent *event) {
+    QWidget::hideEvent(event);
+    // Hidden rings jump to their targets instead of animating unseen
+    finishAnimations();
+}
+
+void CircularMultiProgress::changeEvent(QEvent *event) {
+    QWidget::changeEvent(event);
+    if (event->type() == QEvent::WindowStateChange) updateScheduling();
+}
+
+bool CircularMultiProgress::eventFilter(QObject *watched, QEvent *event) {
+    if ((watched == m_watchedWindow && event->type() == QEvent::WindowStateChange)
+        || (watched == m_watchedHandle && event->type() == QEvent::Expose)) {
+        updateScheduling();
+    }
+    return QWidget::eventFilter(watched, event);
+}
@@ -0,0 +1,119 @@
+#ifndef CIRCULARMULTIPROGRESS_H
+#define CIRCULARMULTIPROGRESS_H
+
+#include <QWidget>
+#include <QEasingCurve>
+#include <QPixmap>
+#include <QPen>
+#include <QPointer>
+#include <QWindow>
+#include <QVector>
+#include "circularprogressrenderer.h"
+#include "progressanimation.h"
+#include "progressanimationdriver.h"
+
+// Many progress values in one widget: concentric rings from the outside in, or
+// one ring split into segments. All tracks come from one cached layer, values
+// are set in bulk and only rings whose value changed are animated and repainted.
+// Values are fractions in 0..1. Ring geometry, caps and gradients follow the
+// theme exactly like CircularProgressBar.
+class CircularMultiProgress : public QWidget, private ProgressAnimationClient {
+    Q_OBJECT
+
+public:
+    enum RingLayout {
+        Concentric,
+        Segmented
+    };
+
+    explicit CircularMultiProgress(QWidget *parent = nullptr);
+    ~CircularMultiProgress();
+
+    void setRingLayout(RingLayout layout);
+    RingLayout ringLayout() const { return m_layout; }
+
+    void setRingCount(int count);
+    int ringCount() const { return m_target.size(); }
+
+    // Resizes to count rings when needed
+    void setValues(const float *values, int count);
+    void setValues(const QVector<float> &values) { setValues(values.constData(), values.size()); }
+    void setValue(int index, float value);
+    float value(int index) const { return m_target.value(index); }
+    float displayedValue(int index) const { return m_current.value(index); }
+
+    void setTheme(const CircularProgressTheme &theme);
+    const CircularProgressTheme &theme() const { return m_theme; }
+
+    // Pixels between concentric rings, degrees between segments
+    void setRingSpacing(int spacing);
+    int ringSpacing() const { return m_ringSpacing; }
+    void setSegmentGap(qreal degrees);
+    qreal segmentGap() const { return m_segmentGap; }
+
+    // Every ring animates like CircularProgressBar's value, with a fixed
+    // duration when eased; 0 shows new values immediately
+    void setAnimationDuration(int msec);
+    int animationDuration() const { return m_duration; }
+    void setEasingCurve(const QEasingCurve &curve);
+    const QEasingCurve &easingCurve() const { return m_animation.easingCurve(); }
+    void setAnimationMode(ProgressValueAnimation::Mode mode);
+    ProgressValueAnimation::Mode animationMode() const { return m_animation.mode(); }
+    void setSpringResponse(int msec);
+    int springResponse() const { return m_animation.springResponse(); }
+
+    QSize sizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+    void changeEvent(QEvent *event) override;
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    void advanceAnimation(qint64 frameTime) override;
+    void updateScheduling();
+    void watchWindow();
+    void finishAnimations();
+    // New target of one ring; repaints go into dirty when not animated
+    void applyValue(int index, float value, bool animate, QRegion *dirty);
+    void invalidateStaticLayer();
+    void ensureStaticLayer();
+
+    QRect ringBounds() const;
+    // Arc of one ring or segment: center line rect, start and span in
+    // degrees clockwise from 12 o'clock
+    void ringArc(int index, QRect *rect, qreal *start, qreal *span) const;
+    QRect dirtyRect(int index) const;
+
+    CircularProgressTheme m_theme;
+    RingLayout m_layout = Concentric;
+    int m_ringSpacing = 2;
+    qreal m_segmentGap = 4;
+    int m_duration = 250;
+    // Settings every ring's animation is copied from
+    ProgressValueAnimation m_animation;
+
+    // Per ring state, kept in flat arrays for the bulk API
+    QVector<float> m_target;
+    QVector<float> m_current;
+    QVector<ProgressValueAnimation> m_animations;
+    QVector<int> m_active;
+    qint64 m_lastFrameTime = 0;
+    bool m_registered = false;
+    // Minimizing or covering the window pauses the rings
+    QPointer<QWidget> m_watchedWindow;
+    QPointer<QWindow> m_watchedHandle;
+
+    // Tracks of all rings and the pens shared by them
+    QPixmap m_staticLayer;
+    QSize m_staticLayerSize;
+    qreal m_staticLayerDpr = 0;
+    bool m_staticLayerDirty = true;
+    QPen m_progressPen;
+    QPen m_highlightPen;
+};
+
+#endif // CIRCULARMULTIPROGRESS_H
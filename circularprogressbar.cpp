@@ -1,18 +1,31 @@
 #include "circularprogressbar.h"
+#include "progressanimationdriver.h"
+#include "spinneratlas.h"
+#include "progressrasterizer.h"
+#include "progressqualitygovernor.h"
+#include "progresssource.h"
+#include "circularprogressrenderer.h"
 #include <QPainterPath>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QResizeEvent>
+#include <QtMath>
+#include <cmath>
 
 CircularProgressBar::CircularProgressBar(QWidget *parent) : QProgressBar(parent) {
     setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
     setMinimumSize(50, 50);
     resize(width, height);
 
-    paint = new QPainter();
-    m_timer = new QTimer(this);
-    animation = new QPropertyAnimation(this, "animationProgress");
-    animation->setEasingCurve(m_curve);
-    animation->setDuration(200);
+    connect(this, &QProgressBar::valueChanged, this, [this](){
+        if(!m_flags.infiniteLoop) updateProgressAnimation();
+    });
+
+    setupAnimations();
+}
+
+QPushButton *CircularProgressBar::ensureStopButton() {
+    if (stopButton) return stopButton;
 
     stopButton = new QPushButton(this);
     stopButton->setVisible(false);
@@ -21,33 +34,65 @@ CircularProgressBar::CircularProgressBar(QWidget *parent) : QProgressBar(parent)
     stopButton->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
     stopButton->setStyleSheet("background:rgba(193, 195, 196,0.6); border-radius: 6px; border: none;");
     stopButton->setIconSize(QSize(24, 24));
-
-    connect(m_timer, &QTimer::timeout, this, &CircularProgressBar::updateChunkPosition);
-    connect(animation, &QPropertyAnimation::valueChanged, this, [this](){ update(); });
-    connect(this, &QProgressBar::valueChanged, this, [this](){
-        if(!infiniteloop) updateProgressAnimation();
-    });
     connect(stopButton, &QPushButton::clicked, this, &CircularProgressBar::stopEmitted);
+    return stopButton;
+}
 
-    setupAnimations();
+void CircularProgressBar::updateStopButton() {
+    // Spinners keep whatever the determinate mode showed
+    if (m_flags.infiniteLoop) return;
+
+    if (m_theme->textEnabled) {
+        if (stopButton) stopButton->setVisible(false);
+    } else {
+        ensureStopButton();
+        layoutStopButton();
+        stopButton->setVisible(true);
+    }
+}
+
+void CircularProgressBar::layoutStopButton() {
+    if (!stopButton) return;
+
+    int btnSize = qMin(width, height) / 2;
+    stopButton->setGeometry(
+        marginX + (width - btnSize) / 2,
+        marginY + (height - btnSize) / 2,
+        btnSize, btnSize
+        );
 }
 
 CircularProgressBar::~CircularProgressBar() {
-    delete paint;
-    delete animation;
-    if (m_timer->isActive()) m_timer->stop();
-    delete m_timer;
+    if (m_stats) qCDebug(lcCircularProgressStats) << this << *m_stats;
+    if (m_flags.registered) ProgressAnimationDriver::instance()->unregisterClient(this);
 }
 
 void CircularProgressBar::setCircularDegree(int value)
 {
-    circularDegree=value;
+    m_theme.edit().circularDegree=value;
+    scheduleStyleUpdate();
 
     emit SI_circularDegreeChanged(value);
 }
 
+void CircularProgressBar::setBgColor(const QColor &color)
+{
+    m_theme.edit().backgroundColor=color;
+    scheduleStyleUpdate();
+
+    emit SI_backgroundColorChanged(color);
+}
+
+void CircularProgressBar::setChunkColor(const QColor &color)
+{
+    m_theme.edit().chunkColor=color;
+    scheduleStyleUpdate();
+
+    emit SI_chunkColorChanged(color);
+}
+
 void CircularProgressBar::setupAnimations() {
-    m_timer->start(m_duration); // ~60fps
+    // Ticks come from the shared ProgressAnimationDriver, only while animating
     QTimer::singleShot(0, this, [this]() {
         if (maximum() == minimum()) {
             setInfiniteLoop(true);
@@ -67,112 +112,484 @@ void CircularProgressBar::setAngle(int angle)
     startAngle=angle;
 }
 
+void CircularProgressBar::setEasingCurve(QEasingCurve::Type curve)
+{
+    m_valueAnimation.setEasingCurve(QEasingCurve(curve));
+}
+
+void CircularProgressBar::setAnimationMode(ProgressValueAnimation::Mode mode)
+{
+    if (mode == m_valueAnimation.mode()) return;
+
+    // Continue a running transition from where it is now in the new mode
+    bool running = m_valueAnimation.isRunning();
+    float target = m_valueAnimation.target();
+    m_valueAnimation.setMode(mode);
+    if (running) m_valueAnimation.start(m_animationProgress, target);
+}
+
+void CircularProgressBar::setSpringResponse(int msec)
+{
+    m_valueAnimation.setSpringResponse(msec);
+}
+
 void CircularProgressBar::updateProgressAnimation() {
     float range = maximum() - minimum();
     float target = (range > 0) ? (value() - minimum()) / range : 0.0f;
     float delta = std::abs(target - m_animationProgress);
 
-    if (value() >= maximum() || delta >= m_threshold) {
-        animation->stop();
-        animation->setStartValue(m_animationProgress);
-        animation->setEndValue(target);
-        animation->setDuration(qBound(100, static_cast<int>(delta * 1000), 1000));
-        animation->start();
+    // A spring takes every new target in stride, no need to filter small steps
+    bool spring = m_valueAnimation.mode() == ProgressValueAnimation::Spring;
+    if (spring || value() >= maximum() || delta >= m_threshold) {
+        if (m_stats && (!spring || !m_valueAnimation.isRunning()))
+            ProgressInstrumentation::recordAnimationRestart(*m_stats);
+        m_valueAnimation.start(m_animationProgress, target);
+        updateScheduling();
+        // A frozen label only changes here, with the target
+        if (m_theme->textEnabled && (m_degradations & ProgressQualityGovernor::FreezeText))
+            update(textBounds(progressRect()));
+    }
+}
+
+bool CircularProgressBar::isAnimationVisible(const QWidget *widget) {
+    if (!widget->isVisible()) return false;
+
+    const QWidget *top = widget->window();
+    if (top->isMinimized()) return false;
+
+    // Covered or off-screen windows are reported as not exposed
+    const QWindow *handle = top->windowHandle();
+    return !handle || handle->isExposed();
+}
+
+void CircularProgressBar::updateScheduling() {
+    // A paused value animation keeps its elapsed time, so it resumes where it stopped
+    bool needsTicks = (m_flags.infiniteLoop || m_valueAnimation.isRunning() || m_flags.feedActive || m_source)
+                      && isAnimationVisible(this);
+    if (needsTicks == m_flags.registered) return;
+
+    ProgressAnimationDriver *driver = ProgressAnimationDriver::instance();
+    m_flags.registered = needsTicks;
+    if (m_flags.registered) {
+        m_lastFrameTime = driver->elapsed();
+        driver->registerClient(this);
+    } else {
+        driver->unregisterClient(this);
+    }
+}
+
+void CircularProgressBar::advanceAnimation(qint64 frameTime) {
+    qint64 delta = qMax<qint64>(0, frameTime - m_lastFrameTime);
+    m_lastFrameTime = frameTime;
+
+    if (m_flags.feedActive) sampleFeed();
+    if (m_source) sampleSource();
+
+    int steps = 0;
+    if (m_flags.infiniteLoop) {
+        // The phase follows the clock, a late tick jumps over the missed steps
+        int angle = m_spinner.angleAt(frameTime);
+        if (angle != startAngle) {
+            steps = ((startAngle - angle) % 360 + 360) % 360 / SpinnerPhase::Step;
+            updateChunkPosition(angle);
+        }
+    } else if (m_valueAnimation.isRunning()) {
+        float previous = m_animationProgress;
+        setAnimationProgress(m_valueAnimation.advance(delta));
+        updateProgressRegion(previous, m_animationProgress);
+
+        if (!m_valueAnimation.isRunning()) updateScheduling();
+    }
+
+    if (m_stats) {
+        bool late = delta * 2 > ProgressAnimationDriver::instance()->interval() * 3;
+        ProgressInstrumentation::recordTick(*m_stats, late, steps);
     }
 }
 
+void CircularProgressBar::setInstrumentationEnabled(bool enable) {
+    if (enable == isInstrumentationEnabled()) return;
+
+    if (enable) {
+        m_stats.reset(new ProgressStats);
+    } else {
+        qCDebug(lcCircularProgressStats) << this << *m_stats;
+        m_stats.reset();
+    }
+}
+
+ProgressStats CircularProgressBar::instrumentationStats() const {
+    return m_stats ? *m_stats : ProgressStats();
+}
+
+void CircularProgressBar::resetInstrumentationStats() {
+    if (m_stats) *m_stats = ProgressStats();
+}
+
+void CircularProgressBar::publishValue(int value) {
+    // Latest value wins; the sequence tells the GUI thread something new arrived
+    m_feedValue.store(value, std::memory_order_relaxed);
+    m_feedPublished.fetch_add(1, std::memory_order_release);
+
+    // Only the first value after the feed went idle touches the event loop
+    if (m_feedSleeping.exchange(false, std::memory_order_acq_rel)) {
+        QMetaObject::invokeMethod(this, [this]() {
+            m_flags.feedActive = true;
+            updateScheduling();
+        }, Qt::QueuedConnection);
+    }
+}
+
+void CircularProgressBar::sampleFeed() {
+    quint64 sequence = m_feedPublished.load(std::memory_order_acquire);
+    if (sequence != m_feedSequence) {
+        m_feedSequence = sequence;
+        ++m_feedConsumed;
+        setValue(m_feedValue.load(std::memory_order_relaxed));
+        return;
+    }
+
+    // Nothing new this frame: stop sampling until the next publish wakes us.
+    // Re-check after arming so a value published in between isn't missed.
+    m_flags.feedActive = false;
+    m_feedSleeping.store(true, std::memory_order_release);
+    if (m_feedPublished.load(std::memory_order_acquire) != m_feedSequence
+        && m_feedSleeping.exchange(false, std::memory_order_acq_rel)) {
+        m_flags.feedActive = true;
+    }
+    updateScheduling();
+}
+
+void CircularProgressBar::setProgressSource(ProgressSource *source) {
+    if (m_source == source) return;
+
+    m_source = source;
+    if (m_source) sampleSource();
+    updateScheduling();
+}
+
+void CircularProgressBar::sampleSource() {
+    quint64 current = 0, total = 0;
+    if (!m_source->sample(&current, &total)) return;
+
+    // Same rule as an empty range in setupAnimations(): unknown totals spin
+    if (total == 0) {
+        setInfiniteLoop(true);
+        return;
+    }
+
+    int value = 0, maximum = 0;
+    ProgressSource::mapToRange(current, total, &value, &maximum);
+    if (minimum() != 0 || this->maximum() != maximum) setRange(0, maximum);
+    else if (m_flags.infiniteLoop) setInfiniteLoop(false);
+    setValue(value);
+}
+
 void CircularProgressBar::setInfiniteLoop(bool loop) {
-    if (infiniteloop == loop) return;
+    if (m_flags.infiniteLoop == loop) return;
 
-    infiniteloop = loop;
-    if (infiniteloop) {
-        animation->stop();
-        m_timer->start(m_duration);
+    m_flags.infiniteLoop = loop;
+    m_framePainter = nullptr;
+    if (m_flags.infiniteLoop) {
+        m_valueAnimation.stop();
+        startAngle = m_spinner.angleAt(ProgressAnimationDriver::instance()->elapsed());
     } else {
-        m_timer->stop();
         updateProgressAnimation();
+        updateStopButton();
         repaint();
     }
-    emit modeChanged(infiniteloop);
+    updateScheduling();
+    emit modeChanged(m_flags.infiniteLoop);
+}
+
+QRect CircularProgressBar::progressRect() const {
+    QRect bounds(marginX, marginY, width, height);
+    // The ring shrinks so its blurred, offset shadow stays inside the layer
+    if (m_theme->shadow) {
+        int margin = CircularProgressRenderer::shadowMargin(m_theme.style());
+        bounds.adjust(margin, margin, -margin, -margin);
+    }
+    return CircularProgressRenderer::ringRect(bounds, m_theme.style());
+}
+
+void CircularProgressBar::setSpinnerAtlas(bool enable)
+{
+    if (m_flags.spinnerAtlasEnabled == enable) return;
+
+    m_flags.spinnerAtlasEnabled = enable;
+    m_spinnerAtlas.reset();
+    update();
+}
+
+void CircularProgressBar::setAsyncRaster(bool enable)
+{
+    if (hasAsyncRaster() == enable) return;
+
+    if (enable) {
+        m_rasterizer.reset(new ProgressRasterizer(this, [this]() {
+            update(marginX, marginY, width, height);
+        }));
+        m_flags.rasterDirty = true;
+    } else {
+        m_rasterizer.reset();
+    }
+    update();
+}
+
+quint64 CircularProgressBar::droppedFrames() const {
+    return m_rasterizer ? m_rasterizer->droppedFrames() : 0;
+}
+
+void CircularProgressBar::setQualityLevel(int level)
+{
+    level = qBound(-1, level, ProgressQualityGovernor::LevelCount - 1);
+    if (m_qualityPin == level) return;
+
+    m_qualityPin = static_cast<qint8>(level);
+    updateQuality();
+}
+
+void CircularProgressBar::setAllowedDegradations(ProgressQualityGovernor::Degradations degradations)
+{
+    if (m_allowedDegradations == static_cast<quint8>(degradations)) return;
+
+    m_allowedDegradations = static_cast<quint8>(degradations);
+    updateQuality();
+}
+
+void CircularProgressBar::updateQuality() {
+    ProgressQualityGovernor *governor = ProgressQualityGovernor::instance();
+    int level = m_qualityPin >= 0 ? m_qualityPin : governor->level();
+    ProgressQualityGovernor::Degradations degradations =
+        ProgressQualityGovernor::degradationsFor(level) & allowedDegradations();
+    if (qMin(width, height) >= governor->smallRingSize())
+        degradations &= ~ProgressQualityGovernor::Degradations(ProgressQualityGovernor::DropAntialiasing);
+    quint8 active = static_cast<quint8>(degradations);
+
+    // Degraded bars listen for the governor so they are restored even when idle
+    bool listen = active && m_qualityPin < 0;
+    if (listen != m_flags.qualityListening) {
+        m_flags.qualityListening = listen;
+        if (listen)
+            connect(governor, &ProgressQualityGovernor::levelChanged, this, &CircularProgressBar::updateQuality);
+        else
+            disconnect(governor, &ProgressQualityGovernor::levelChanged, this, &CircularProgressBar::updateQuality);
+    }
+    if (active == m_degradations) return;
+
+    m_degradations = active;
+    invalidateTextCache();
+    invalidateStaticLayer();
+    update();
+}
+
+int CircularProgressBar::labelPercent(qreal proportion) const {
+    // A frozen label shows where the animation is heading
+    if ((m_degradations & ProgressQualityGovernor::FreezeText) && m_valueAnimation.isRunning())
+        proportion = m_valueAnimation.target();
+    return static_cast<int>(proportion * 100);
+}
+
+bool CircularProgressBar::isRasterAsync() const {
+    // The spinner atlas takes precedence over the worker thread
+    return m_rasterizer && !(m_flags.infiniteLoop && m_flags.spinnerAtlasEnabled);
+}
+
+void CircularProgressBar::requestRasterFrame() {
+    QRect rect = progressRect();
+    ensureStaticLayer(rect);
+
+    // Only a state that differs from the last request needs a new frame
+    qreal proportion = m_flags.infiniteLoop ? 0.0 : m_animationProgress;
+    float progress = m_flags.infiniteLoop ? -1.0f : static_cast<float>(proportion);
+    if (!m_flags.rasterDirty && progress == m_rasterProgress && (!m_flags.infiniteLoop || startAngle == m_rasterAngle))
+        return;
+
+    m_flags.rasterDirty = false;
+    m_rasterProgress = progress;
+    m_rasterAngle = startAngle;
+
+    ProgressFrameState state;
+    state.theme = m_degradedStyle ? CircularProgressTheme(*m_degradedStyle) : m_theme;
+    state.progressPen = m_progressPen;
+    state.highlightPen = m_highlightPen;
+    state.font = font();
+    state.size = QSize(width, height);
+    state.dpr = devicePixelRatioF();
+    state.ringRect = rect.translated(-marginX, -marginY);
+    state.progress = proportion;
+    state.labelPercent = labelPercent(proportion);
+    state.antialiasing = !(m_degradations & ProgressQualityGovernor::DropAntialiasing);
+    state.startAngle = startAngle;
+    state.infinite = m_flags.infiniteLoop;
+    m_rasterizer->request(state);
+}
+
+void CircularProgressBar::drawRasterFrame(QPainter *painter, const QRect &rect, qreal proportion) {
+    // Animation ticks post their frames themselves and repaint once one is
+    // ready; this only catches changes made outside a tick (resizes, styles)
+    requestRasterFrame();
+
+    // Until a frame of the current size is ready this one is drawn here
+    QImage frame = m_rasterizer->frame();
+    qreal dpr = devicePixelRatioF();
+    if (!frame.isNull() && qFuzzyCompare(frame.devicePixelRatio(), dpr) && frame.size() == QSize(width, height) * dpr) {
+        painter->drawImage(marginX, marginY, frame);
+        return;
+    }
+
+    const QStaticText *label = m_theme->textEnabled && !m_flags.infiniteLoop
+        ? &m_labelCache.label(labelPercent(proportion), m_theme->suffix, font()) : nullptr;
+    CircularProgressRenderer::drawFrame(painter, rect, renderStyle(), m_progressPen, m_highlightPen,
+                                        proportion, startAngle, m_flags.infiniteLoop, label);
+}
+
+void CircularProgressBar::ensureSpinnerAtlas(const QRect &rect) {
+    if (m_spinnerAtlas) return;
+
+    // Frames are relative to the bar's own square, so margins don't split the cache
+    SpinnerAtlasKey key;
+    key.size = QSize(width, height);
+    key.dpr = devicePixelRatioF();
+    key.rect = rect.translated(-marginX, -marginY);
+    key.chunkLength = m_theme->chunkLength;
+    key.pen = CircularProgressRenderer::progressPen(renderStyle(), key.rect, key.dpr);
+    m_spinnerAtlas = SpinnerAtlas::acquire(key);
+}
+
+void CircularProgressBar::invalidateStaticLayer() {
+    m_flags.staticLayerDirty = true;
+}
+
+void CircularProgressBar::scheduleStyleUpdate() {
+    invalidateStaticLayer();
+    if (m_styleBatch > 0) {
+        m_flags.styleBatchDirty = true;
+        return;
+    }
+    update();
+}
+
+void CircularProgressBar::beginStyleUpdate() {
+    ++m_styleBatch;
+}
+
+void CircularProgressBar::endStyleUpdate() {
+    if (m_styleBatch == 0 || --m_styleBatch > 0) return;
+
+    if (m_flags.styleBatchDirty) {
+        m_flags.styleBatchDirty = false;
+        update();
+    }
+}
+
+void CircularProgressBar::setTheme(const CircularProgressTheme &theme) {
+    if (m_theme.isSharedWith(theme)) return;
+
+    m_theme = theme;
+    invalidateTextCache();
+    scheduleStyleUpdate();
+    updateStopButton();
+    emit SI_themeChanged();
+}
+
+void CircularProgressBar::ensureStaticLayer(const QRect &rect) {
+    qreal dpr = devicePixelRatioF();
+    QSize size(width, height);
+    if (!m_flags.staticLayerDirty && m_staticLayerSize == size && qFuzzyCompare(m_staticLayerDpr, dpr))
+        return;
+
+    // Labels are shaped per DPR, their box follows the ring's center
+    if (!qFuzzyCompare(m_staticLayerDpr, dpr)) m_labelCache.clear();
+    m_textBounds = QRect();
+
+    m_flags.staticLayerDirty = false;
+    m_flags.rasterDirty = true;
+    m_framePainter = nullptr;
+    m_staticLayerSize = size;
+    m_staticLayerDpr = dpr;
+    m_spinnerAtlas.reset();
+
+    // Without its gradient a degraded ring draws from a solid-color copy
+    if ((m_degradations & ProgressQualityGovernor::DropGradient) && m_theme->gradient) {
+        m_degradedStyle.reset(new CircularProgressStyle(m_theme.style()));
+        m_degradedStyle->gradient = false;
+    } else {
+        m_degradedStyle.reset();
+    }
+
+    // Progress pens, including the gradient brush, only change with the style
+    m_progressPen = CircularProgressRenderer::progressPen(renderStyle(), rect, dpr);
+    m_highlightPen = CircularProgressRenderer::highlightPen(renderStyle());
+
+    // Shadow and background track, rendered at device resolution so HiDPI stays sharp
+    if ((!m_theme->backgroundEnabled && !m_theme->shadow) || size.isEmpty()) {
+        m_staticLayer = QPixmap();
+        return;
+    }
+
+    m_staticLayer = QPixmap(size * dpr);
+    m_staticLayer.setDevicePixelRatio(dpr);
+    m_staticLayer.fill(Qt::transparent);
+
+    QPainter layer(&m_staticLayer);
+    layer.setRenderHints(QPainter::Antialiasing);
+    QRect ring = rect.translated(-marginX, -marginY);
+    if (m_theme->shadow)
+        layer.drawImage(0, 0, CircularProgressRenderer::shadowImage(size, dpr, ring, renderStyle()));
+    if (m_theme->backgroundEnabled) CircularProgressRenderer::drawTrack(&layer, ring, renderStyle());
 }
 
 void CircularProgressBar::paintEvent(QPaintEvent *event) {
     Q_UNUSED(event);
 
+    QElapsedTimer paintTimer;
+    if (m_stats) paintTimer.start();
+
+    updateQuality();
+
     QPainter painter(this);
-    painter.setRenderHints(QPainter::Antialiasing);
+    painter.setRenderHint(QPainter::Antialiasing, !(m_degradations & ProgressQualityGovernor::DropAntialiasing));
 
-    int pnwidth = width - progress_width;
-    int pnheight = height - progress_width;
-    int margin = progress_width / 2;
-    QRect rect(marginX + margin, marginY + margin, pnwidth, pnheight);
+    QRect rect = progressRect();
+    ensureStaticLayer(rect);
 
     // Draw background
-    painter.setPen(Qt::NoPen);
-    if (enable_bg) {
-        QPen bgPen;
-        bgPen.setColor(bg_color);
-        bgPen.setWidth(progress_width);
-        bgPen.setCosmetic(true);
-        if (progress_rounded_cap) bgPen.setCapStyle(Qt::RoundCap);
-        painter.setPen(bgPen);
-        painter.drawArc(rect, 90 * 16, -circularDegree * 16);
-    }
+    if (!m_staticLayer.isNull()) painter.drawPixmap(marginX, marginY, m_staticLayer);
 
     // Calculate progress proportion
-    double proportion = infiniteloop ? 0.0 : m_animationProgress;
-
-    // Set progress pen style
-    QPen pen;
-    pen.setWidth(progress_width);
-    pen.setCosmetic(true);
-    if (progress_rounded_cap) pen.setCapStyle(Qt::RoundCap);
-
-    // Set progress color
-    if (proportion > 0.85) {
-        pen.setColor(QColor(71, 158, 245));
+    double proportion = m_flags.infiniteLoop ? 0.0 : m_animationProgress;
+
+    // Draw progress arc and text, spinner frames come from the shared atlas when enabled
+    if (m_flags.infiniteLoop && m_flags.spinnerAtlasEnabled && !rect.isEmpty()) {
+        ensureSpinnerAtlas(rect);
+        painter.drawPixmap(marginX, marginY, m_spinnerAtlas->frame(startAngle));
+    } else if (m_rasterizer) {
+        drawRasterFrame(&painter, rect, proportion);
     } else {
-        pen.setColor(chunk_color);
+        // Specialized for the current configuration, picked again after it changed
+        if (!m_framePainter) {
+            m_framePainter = CircularProgressRenderer::framePainter(renderStyle(), m_progressPen, m_highlightPen,
+                                                                    m_flags.infiniteLoop);
+        }
+
+        CircularProgressFrame frame;
+        frame.ringRect = rect;
+        frame.style = &renderStyle();
+        frame.progressPen = &m_progressPen;
+        frame.highlightPen = &m_highlightPen;
+        frame.progress = proportion;
+        frame.startAngle = startAngle;
+        if (m_theme->textEnabled && !m_flags.infiniteLoop)
+            frame.label = &m_labelCache.label(labelPercent(proportion), m_theme->suffix, font());
+        m_framePainter(&painter, frame);
     }
 
-    // Apply gradient if enabled
-    // Apply gradient if enabled
-    if (gradient && proportion <= 0.85) {
-        QLinearGradient linearGrad(rect.topLeft(), rect.bottomRight());
-        for (auto it = gradient_colors.begin(); it != gradient_colors.end(); ++it) {
-            linearGrad.setColorAt(it.key(), it.value());
-        }
-        pen.setBrush(linearGrad);
-    }
-
-
-    // Draw progress arc
-    painter.setPen(pen);
-    int spanAngle = -(infiniteloop ? m_chunkLength * 16 : proportion * circularDegree * 16);
-    painter.drawArc(rect, 90 * 16 + (infiniteloop ? startAngle * 16 : 0), spanAngle);
-
-    // Draw text or stop button
-    if (enable_text && !infiniteloop) {
-        pen.setColor(text_color);
-        painter.setPen(pen);
-        QString text = QString::number(static_cast<int>(proportion * 100)) + suffix;
-        QFontMetrics metrics = painter.fontMetrics();
-        QRect textRect = metrics.boundingRect(text);
-        QRect centeredRect(
-            rect.center().x() - textRect.width() / 2,
-            rect.center().y() - textRect.height() / 2,
-            textRect.width(), textRect.height()
-            );
-        painter.drawText(centeredRect, textAlignment, text);
-        stopButton->setVisible(false);
-    } else if (!enable_text && !infiniteloop) {
-        int btnSize = qMin(width, height) / 2;
-        stopButton->setGeometry(
-            rect.center().x() - btnSize / 2,
-            rect.center().y() - btnSize / 2,
-            btnSize, btnSize
-            );
-        stopButton->setVisible(true);
+    if (m_stats) {
+        // Measured before QPainter flushes, i.e. the cost of this ring's own drawing
+        qint64 nsecs = paintTimer.nsecsElapsed();
+        ProgressInstrumentation::recordPaint(*m_stats, nsecs);
+        if (nsecs > 16000000) qCDebug(lcCircularProgressStats) << this << "slow paint:" << nsecs / 1000 << "us";
     }
 }
 
@@ -185,40 +602,77 @@ void CircularProgressBar::setValue(int value) {
 
 void CircularProgressBar::setGradient(bool enable)
 {
-    gradient=enable;
-
-    repaint();
+    m_theme.edit().gradient=enable;
+    scheduleStyleUpdate();
 }
 
 void CircularProgressBar::setGradientValues(const QMap<qreal, QColor> &map)
 {
-    gradient_colors=map;
+    m_theme.edit().gradientColors=map;
+    // Arc gradients look colors up in this table instead of interpolating stops
+    m_theme.edit().gradientTable=CircularProgressRenderer::gradientTable(map);
+    scheduleStyleUpdate();
+}
 
-    repaint();
+void CircularProgressBar::setGradientMode(CircularProgressStyle::GradientMode mode)
+{
+    m_theme.edit().gradientMode=mode;
+    scheduleStyleUpdate();
+    emit SI_gradientModeChanged(mode);
 }
 
 void CircularProgressBar::setProgressWidth(int width)
 {
-    progress_width=width;
-    repaint();
+    m_theme.edit().progressWidth=width;
+    scheduleStyleUpdate();
 }
 
 void CircularProgressBar::setProgressRoundedCap(bool enable)
 {
-    progress_rounded_cap=enable;
-    repaint();
+    m_theme.edit().roundedCap=enable;
+    scheduleStyleUpdate();
+}
+
+void CircularProgressBar::setShadow(bool enable)
+{
+    if (m_theme->shadow == enable) return;
+    m_theme.edit().shadow=enable;
+    scheduleStyleUpdate();
+    emit SI_shadowChanged(enable);
+}
+
+void CircularProgressBar::setShadowColor(const QColor &color)
+{
+    m_theme.edit().shadowColor=color;
+    scheduleStyleUpdate();
+    emit SI_shadowColorChanged(color);
+}
+
+void CircularProgressBar::setShadowBlurRadius(int radius)
+{
+    m_theme.edit().shadowBlurRadius=qMax(0, radius);
+    scheduleStyleUpdate();
+    emit SI_shadowBlurRadiusChanged(m_theme->shadowBlurRadius);
+}
+
+void CircularProgressBar::setShadowOffset(const QPoint &offset)
+{
+    m_theme.edit().shadowOffset=offset;
+    scheduleStyleUpdate();
+    emit SI_shadowOffsetChanged(offset);
 }
 
 void CircularProgressBar::setEnableBg(bool enable)
 {
-    enable_bg=enable;
-    repaint();
+    m_theme.edit().backgroundEnabled=enable;
+    scheduleStyleUpdate();
 }
 
 void CircularProgressBar::setEnableText(bool enable)
 {
-    enable_text=enable;
-    repaint();
+    m_theme.edit().textEnabled=enable;
+    scheduleStyleUpdate();
+    updateStopButton();
 }
 
 void CircularProgressBar::setRange(int minValue, int maxValue) {
@@ -230,7 +684,7 @@ void CircularProgressBar::setRange(int minValue, int maxValue) {
     //bool wasInfinite = !infiniteloop && (maximum() == minimum());
     QProgressBar::setRange(minValue, maxValue);
 
-    if (infiniteloop && (maxValue > minValue)) {
+    if (m_flags.infiniteLoop && (maxValue > minValue)) {
         setInfiniteLoop(false);
     } else if (maxValue == minValue) {
         setInfiniteLoop(true);
@@ -239,37 +693,182 @@ void CircularProgressBar::setRange(int minValue, int maxValue) {
 
 void CircularProgressBar::setChunkLength(double length)
 {
-    m_chunkLength=length;
-    repaint();
+    m_theme.edit().chunkLength=length;
+    scheduleStyleUpdate();
 }
 
 void CircularProgressBar::setDuration(short duration)
 {
-    if(infiniteloop) {
-        setInfiniteLoop(false);
-        m_duration=duration;
-        setInfiniteLoop(true);
+    // Picked up by the next driver tick, no timer restart needed
+    m_spinner.setDuration(duration);
+}
+
+void CircularProgressBar::setAngularVelocity(qreal degreesPerSecond)
+{
+    m_spinner.setAngularVelocity(degreesPerSecond);
+}
+
+void CircularProgressBar::updateChunkPosition(int angle) {
+    int previous = startAngle;
+    startAngle = angle;
+
+    // The worker's frame repaints the bar when it is ready
+    if (isRasterAsync()) {
+        requestRasterFrame();
+        return;
     }
 
-    m_duration=duration;
+    // Only the old and new chunk positions need repainting
+    QRect rect = progressRect();
+    update(arcRegion(rect, 90 + previous, -m_theme->chunkLength)
+           + arcRegion(rect, 90 + startAngle, -m_theme->chunkLength));
 }
 
-void CircularProgressBar::updateChunkPosition() {
-    startAngle -= 6;
-    if (startAngle < 0) startAngle += 360;
-    update();
+void CircularProgressBar::updateProgressRegion(float from, float to) {
+    if (from == to) return;
+    if (isRasterAsync()) {
+        requestRasterFrame();
+        return;
+    }
+
+    QRect rect = progressRect();
+    QRegion region;
+    const float threshold = static_cast<float>(m_theme->highlightThreshold);
+    const CircularProgressStyle &style = renderStyle();
+    const bool stretched = style.gradient && style.gradientMode == CircularProgressStyle::FilledArcGradient;
+    if (stretched || (from > threshold) != (to > threshold)) {
+        // Crossing the highlight threshold recolors the whole arc, and so does
+        // a gradient stretched over the filled span
+        region = arcRegion(rect, 90, -qMax(from, to) * m_theme->circularDegree);
+    } else {
+        region = arcRegion(rect, 90 - from * m_theme->circularDegree, (from - to) * m_theme->circularDegree);
+    }
+
+    if (m_theme->textEnabled && !(m_degradations & ProgressQualityGovernor::FreezeText)
+        && static_cast<int>(from * 100) != static_cast<int>(to * 100))
+        region += textBounds(rect);
+
+    update(region);
+}
+
+QRegion CircularProgressBar::arcRegion(const QRect &rect, qreal startDeg, qreal spanDeg) const {
+    QRegion region;
+    if (qFuzzyIsNull(spanDeg)) return region;
+
+    const QPointF center = QRectF(rect).center();
+    const qreal rx = rect.width() / 2.0;
+    const qreal ry = rect.height() / 2.0;
+    // Half the pen plus square caps and antialiasing
+    const int pad = qCeil(m_theme->progressWidth * 0.75) + 2;
+
+    auto pointAt = [&](qreal deg) {
+        qreal rad = qDegreesToRadians(deg);
+        return QPointF(center.x() + rx * qCos(rad), center.y() - ry * qSin(rad));
+    };
+
+    // Bound the sector piecewise so long spans stay close to the annulus shape
+    const qreal from = qMin(startDeg, startDeg + spanDeg);
+    const qreal to = qMax(startDeg, startDeg + spanDeg);
+    for (qreal a = from; a < to; a += 30.0) {
+        qreal b = qMin(a + 30.0, to);
+        QPointF p0 = pointAt(a);
+        QPointF p1 = pointAt(b);
+        qreal left = qMin(p0.x(), p1.x()), right = qMax(p0.x(), p1.x());
+        qreal top = qMin(p0.y(), p1.y()), bottom = qMax(p0.y(), p1.y());
+
+        // Extremes of the ellipse lying inside the piece
+        for (qreal k = std::ceil(a / 90.0) * 90.0; k < b; k += 90.0) {
+            QPointF p = pointAt(k);
+            left = qMin(left, p.x());
+            right = qMax(right, p.x());
+            top = qMin(top, p.y());
+            bottom = qMax(bottom, p.y());
+        }
+
+        region += QRectF(QPointF(left, top), QPointF(right, bottom)).toAlignedRect()
+                      .adjusted(-pad, -pad, pad, pad);
+    }
+    return region;
+}
+
+QRect CircularProgressBar::textBounds(const QRect &rect) {
+    // Sized for the widest label so growing digits are always covered
+    if (m_textBounds.isNull()) {
+        QRect textRect = fontMetrics().boundingRect(CircularProgressRenderer::labelText(100, m_theme->suffix));
+        textRect.moveCenter(rect.center());
+        m_textBounds = textRect.adjusted(-2, -2, 2, 2);
+    }
+    return m_textBounds;
+}
+
+void CircularProgressBar::invalidateTextCache() {
+    m_labelCache.clear();
+    m_flags.rasterDirty = true;
+    m_textBounds = QRect();
+}
+
+void CircularProgressBar::setSuffix(const QString &suffix)
+{
+    m_theme.edit().suffix=suffix;
+    invalidateTextCache();
+    scheduleStyleUpdate();
+
+    emit SI_suffixChanged(suffix);
 }
 
 void CircularProgressBar::stop() {
-    m_stop = true;
+    m_flags.stopped = true;
     setInfiniteLoop(false);
-    animation->stop();
+    m_valueAnimation.stop();
+    updateScheduling();
+}
+
+void CircularProgressBar::watchWindow() {
+    QWidget *top = window();
+    if (top != m_watchedWindow) {
+        if (m_watchedWindow) m_watchedWindow->removeEventFilter(this);
+        m_watchedWindow = top;
+        // The bar may be the window itself; its own events already reach changeEvent()
+        if (top != this) top->installEventFilter(this);
+    }
+
+    QWindow *handle = top->windowHandle();
+    if (handle != m_watchedHandle) {
+        if (m_watchedHandle) m_watchedHandle->removeEventFilter(this);
+        m_watchedHandle = handle;
+        if (handle) handle->installEventFilter(this);
+    }
+}
+
+void CircularProgressBar::showEvent(QShowEvent *event) {
+    QProgressBar::showEvent(event);
+    watchWindow();
+    updateScheduling();
+}
+
+void CircularProgressBar::hideEvent(QHideEvent *event) {
+    QProgressBar::hideEvent(event);
+    updateScheduling();
+}
+
+void CircularProgressBar::changeEvent(QEvent *event) {
+    QProgressBar::changeEvent(event);
+    if (event->type() == QEvent::WindowStateChange) updateScheduling();
+    if (event->type() == QEvent::FontChange) invalidateTextCache();
+}
+
+bool CircularProgressBar::eventFilter(QObject *watched, QEvent *event) {
+    if ((watched == m_watchedWindow && event->type() == QEvent::WindowStateChange)
+        || (watched == m_watchedHandle && event->type() == QEvent::Expose)) {
+        updateScheduling();
+    }
+    return QProgressBar::eventFilter(watched, event);
 }
 
 void CircularProgressBar::resizeEvent(QResizeEvent *event) {
     QSize size = event->size();
 
-    if (square) {
+    if (m_flags.square) {
         width = height = qMin(size.width(), size.height());
         if (progressAlignment & Qt::AlignCenter) {
             marginX = (size.width() - width) / 2;
@@ -285,15 +884,10 @@ void CircularProgressBar::resizeEvent(QResizeEvent *event) {
         height = size.height();
         marginX = marginY = 0;
     }
+    invalidateStaticLayer();
+    m_textBounds = QRect();
 
-    if (stopButton->isVisible()) {
-        int btnSize = qMin(width, height) / 2;
-        stopButton->setGeometry(
-            marginX + (width - btnSize) / 2,
-            marginY + (height - btnSize) / 2,
-            btnSize, btnSize
-            );
-    }
+    layoutStopButton();
 
     update();
 }
@@ -2,14 +2,27 @@
 #define CIRCULARPROGRESSBAR_H
 
 #include <QProgressBar>
-#include <QPropertyAnimation>
 #include <QPainter>
 #include <QPushButton>
 #include <QEasingCurve>
-#include <QGraphicsDropShadowEffect>
 #include <QTimer>
+#include <QStaticText>
+#include <QPointer>
+#include <QWindow>
+#include <QSharedPointer>
+#include <QScopedPointer>
+#include <atomic>
+#include "circularprogressrenderer.h"
+#include "progressanimation.h"
+#include "progressanimationdriver.h"
+#include "progressinstrumentation.h"
+#include "progressqualitygovernor.h"
 
-class CircularProgressBar : public QProgressBar {
+class SpinnerAtlas;
+class ProgressRasterizer;
+class ProgressSource;
+
+class CircularProgressBar : public QProgressBar, private ProgressAnimationClient {
     Q_OBJECT
     Q_PROPERTY(int startAngle READ angle WRITE setAngle NOTIFY startAngleChanged)
     Q_PROPERTY(float animationProgress READ animationProgress WRITE setAnimationProgress NOTIFY animationProgressChanged)
@@ -25,10 +38,15 @@ public:
     void setSquare(bool enable = false);
     void setGradient(bool enable = false);
     void setGradientValues(const QMap<qreal, QColor> &map);
+    void setGradientMode(CircularProgressStyle::GradientMode mode);
     void setMargin(int x = 0, int y = 0);
     void setTextAlignment(Qt::Alignment alignment = Qt::AlignCenter);
     void setProgressAlignment(Qt::Alignment alignment = Qt::AlignCenter);
+    // The shadow is blurred once into the cached background, not per frame
     void setShadow(bool enable = true);
+    void setShadowColor(const QColor &color);
+    void setShadowBlurRadius(int radius);
+    void setShadowOffset(const QPoint &offset);
     void setWidth(int width = 200);
     void setHeight(int height = 200);
     void setProgressWidth(int width = 10);
@@ -44,37 +62,106 @@ public:
     void setTextColor(const QColor &color = QColor(73, 139, 209));
     void setRange(int minValue, int maxValue);
     void setEasingCurve(QEasingCurve::Type curve);
+    // Spring absorbs value changes mid-flight instead of restarting the easing curve
+    void setAnimationMode(ProgressValueAnimation::Mode mode);
+    void setSpringResponse(int msec);
     void setChunkLength(double length);
+    // Spinner speed as ms per 6° step, or as degrees per second
     void setDuration(short duration);
+    void setAngularVelocity(qreal degreesPerSecond);
     void setAnimationProgress(float progress);
     void setAnimationThreshold(float threshold);
+    // Share pre-rendered spinner frames between bars with identical style.
+    // Costs 60 frames of the bar's size in pixmap memory per distinct style.
+    void setSpinnerAtlas(bool enable);
+    // Renders the arc and label on a worker pool; animation ticks post their
+    // state there and the bar repaints once per finished frame, so frames may
+    // lag the state by one tick.
+    // Intermediate states are dropped when workers fall behind.
+    void setAsyncRaster(bool enable);
+
+    // Thread-safe progress feed: any thread may publish, the bar picks up
+    // the latest value once per displayed frame without queued signals.
+    void publishValue(int value);
+    quint64 publishedUpdates() const { return m_feedPublished.load(std::memory_order_relaxed); }
+    quint64 consumedUpdates() const { return m_feedConsumed; }
+
+    // Polls source once per displayed frame instead of being sent values.
+    // 64-bit counts are mapped onto the int range, an unknown total (0)
+    // shows the spinner. Not owned, nullptr unbinds.
+    void setProgressSource(ProgressSource *source);
+    ProgressSource *progressSource() const { return m_source; }
+
+    // Replaces the whole style at once with a single deferred update.
+    // Bars given the same theme share its data.
+    void setTheme(const CircularProgressTheme &theme);
+    // Style setters between these only invalidate caches, the outermost
+    // endStyleUpdate() schedules one update for all of them
+    void beginStyleUpdate();
+    void endStyleUpdate();
+
+    // Opt-in paint and animation statistics, also summed into
+    // ProgressInstrumentation::globalStats(). Disabled rings only pay a null check.
+    void setInstrumentationEnabled(bool enable);
+    bool isInstrumentationEnabled() const { return !m_stats.isNull(); }
+    ProgressStats instrumentationStats() const;
+    void resetInstrumentationStats();
+
+    // Quality under load follows ProgressQualityGovernor. A pinned level
+    // (-1 follows the governor again) ignores it, and only the allowed
+    // degradations are ever applied to this bar.
+    void setQualityLevel(int level);
+    void setAllowedDegradations(ProgressQualityGovernor::Degradations degradations);
 
     // Getters
-    double chunkLength() const { return m_chunkLength; }
-    int getCircularDegree() const { return circularDegree; }
+    double chunkLength() const { return m_theme->chunkLength; }
+    int getCircularDegree() const { return m_theme->circularDegree; }
     int getMarginX() const { return marginX; }
     int getMarginY() const { return marginY; }
     int getWidth() const { return width; }
-    bool isSquared() const { return square; }
-    bool hasGradient() const { return gradient; }
-    QMap<qreal, QColor> getGradientValues() const { return gradient_colors; }
+    bool isSquared() const { return m_flags.square; }
+    bool hasGradient() const { return m_theme->gradient; }
+    QMap<qreal, QColor> getGradientValues() const { return m_theme->gradientColors; }
+    CircularProgressStyle::GradientMode getGradientMode() const { return m_theme->gradientMode; }
     int getHeight() const { return height; }
-    int getProgressWidth() const { return progress_width; }
+    int getProgressWidth() const { return m_theme->progressWidth; }
     Qt::Alignment getTextAlignment() const { return textAlignment; }
     Qt::Alignment getProgressAlignment() const { return progressAlignment; }
-    bool hasShadow() const { return shadow; }
-    bool hasRoundedCap() const { return progress_rounded_cap; }
-    bool isBackgroundEnabled() const { return enable_bg; }
-    QColor getBgColor() const { return bg_color; }
-    QColor getChunkColor() const { return chunk_color; }
-    bool isTextEnabled() const { return enable_text; }
-    QString getSuffix() const { return suffix; }
-    QColor getTextColor() const { return text_color; }
+    bool hasShadow() const { return m_theme->shadow; }
+    QColor shadowColor() const { return m_theme->shadowColor; }
+    int shadowBlurRadius() const { return m_theme->shadowBlurRadius; }
+    QPoint shadowOffset() const { return m_theme->shadowOffset; }
+    bool hasRoundedCap() const { return m_theme->roundedCap; }
+    bool isBackgroundEnabled() const { return m_theme->backgroundEnabled; }
+    QColor getBgColor() const { return m_theme->backgroundColor; }
+    QColor getChunkColor() const { return m_theme->chunkColor; }
+    bool isTextEnabled() const { return m_theme->textEnabled; }
+    QString getSuffix() const { return m_theme->suffix; }
+    QColor getTextColor() const { return m_theme->textColor; }
+    const CircularProgressStyle &progressStyle() const { return m_theme.style(); }
+    const CircularProgressTheme &theme() const { return m_theme; }
     float animationProgress() const { return m_animationProgress; }
     float animationThreshold() const { return m_threshold; }
-    bool isInfiniteLoop() const { return infiniteloop; }
+    ProgressValueAnimation::Mode animationMode() const { return m_valueAnimation.mode(); }
+    int springResponse() const { return m_valueAnimation.springResponse(); }
+    qreal angularVelocity() const { return m_spinner.angularVelocity(); }
+    bool isInfiniteLoop() const { return m_flags.infiniteLoop; }
+    bool hasSpinnerAtlas() const { return m_flags.spinnerAtlasEnabled; }
+    bool hasAsyncRaster() const { return !m_rasterizer.isNull(); }
+    quint64 droppedFrames() const;
+    int pinnedQualityLevel() const { return m_qualityPin; }
+    ProgressQualityGovernor::Degradations allowedDegradations() const {
+        return ProgressQualityGovernor::Degradations(m_allowedDegradations);
+    }
+    ProgressQualityGovernor::Degradations activeDegradations() const {
+        return ProgressQualityGovernor::Degradations(m_degradations);
+    }
     void stop();
-    bool isStopped() const { return m_stop; }
+    bool isStopped() const { return m_flags.stopped; }
+
+    // Whether widget's animations can be seen: it is visible and its window
+    // is neither minimized nor unexposed. Shared with CircularMultiProgress.
+    static bool isAnimationVisible(const QWidget *widget);
 
 signals:
     void modeChanged(bool isInfinite);
@@ -82,11 +169,16 @@ signals:
     void SI_circularDegreeChanged(int value);
     void SI_valueChanged(int value);
     void SI_shadowChanged(bool enable);
+    void SI_shadowColorChanged(QColor color);
+    void SI_shadowBlurRadiusChanged(int radius);
+    void SI_shadowOffsetChanged(QPoint offset);
     void SI_squareChanged(bool enable);
     void SI_marginChanged(int x, int y);
     void SI_widthChanged(int width);
     void SI_gradientChanged(bool enable);
     void SI_gradientValuesChanged(QMap<qreal, QColor> map);
+    void SI_gradientModeChanged(int mode);
+    void SI_themeChanged();
     void SI_heightChanged(int height);
     void SI_textAlignmentChanged(Qt::Alignment alignment);
     void SI_progressAlignmentChanged(Qt::Alignment alignment);
@@ -105,51 +197,120 @@ signals:
 protected:
     void paintEvent(QPaintEvent *event) override;
     void resizeEvent(QResizeEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+    void changeEvent(QEvent *event) override;
+    bool eventFilter(QObject *watched, QEvent *event) override;
 
 private:
-    void updateChunkPosition();
+    void advanceAnimation(qint64 frameTime) override;
+    void updateScheduling();
+    void sampleFeed();
+    void sampleSource();
+    void watchWindow();
+    QRect progressRect() const;
+    void invalidateStaticLayer();
+    void scheduleStyleUpdate();
+    void ensureStaticLayer(const QRect &rect);
+    void ensureSpinnerAtlas(const QRect &rect);
+    bool isRasterAsync() const;
+    void requestRasterFrame();
+    void drawRasterFrame(QPainter *painter, const QRect &rect, qreal proportion);
+    void updateQuality();
+    const CircularProgressStyle &renderStyle() const { return m_degradedStyle ? *m_degradedStyle : m_theme.style(); }
+    int labelPercent(qreal proportion) const;
+    void updateChunkPosition(int angle);
     void updateProgressAnimation();
+    void updateProgressRegion(float from, float to);
+    QRegion arcRegion(const QRect &rect, qreal startDeg, qreal spanDeg) const;
+    QRect textBounds(const QRect &rect);
+    void invalidateTextCache();
     void setupAnimations();
+    QPushButton *ensureStopButton();
+    // Shown instead of the label on determinate bars; never touched while painting
+    void updateStopButton();
+    void layoutStopButton();
     int angle() const { return startAngle; }
     void setAngle(int angle);
 
-    QPainter *paint = nullptr;
-    QPropertyAnimation *animation = nullptr;
-    QTimer *m_timer = nullptr;
+    // Created on first use, most bars never show it
     QPushButton *stopButton = nullptr;
+    QPointer<QWidget> m_watchedWindow;
+    QPointer<QWindow> m_watchedHandle;
 
     // Visual properties
-    bool square = true;
-    int circularDegree = 360;
     int width = 100;
     int height = 100;
     int marginX = 0;
     int marginY = 0;
-    int progress_width = 10;
-    bool shadow = false;
-    bool progress_rounded_cap = true;
-    bool enable_bg = true;
-    bool gradient = false;
-    bool enable_text = true;
-    bool infiniteloop = false;
-    bool m_stop = false;
+
+    // On/off state packed into one word instead of a padded byte each
+    struct Flags {
+        Flags()
+            : square(true), infiniteLoop(false), stopped(false), registered(false),
+              feedActive(false), staticLayerDirty(true), spinnerAtlasEnabled(false), styleBatchDirty(false),
+              rasterDirty(true), qualityListening(false) {}
+
+        bool square : 1;
+        bool infiniteLoop : 1;
+        bool stopped : 1;
+        bool registered : 1;
+        bool feedActive : 1;
+        bool staticLayerDirty : 1;
+        bool spinnerAtlasEnabled : 1;
+        bool styleBatchDirty : 1;
+        bool rasterDirty : 1;
+        bool qualityListening : 1;
+    } m_flags;
 
     // Animation properties
     float m_animationProgress = 0.0f;
     float m_threshold = 0.02f;
     int startAngle = 0;
-    short m_duration = 18;
-    double m_chunkLength = 135;
-    QEasingCurve::Type m_curve = QEasingCurve::OutQuart;
+    ProgressValueAnimation m_valueAnimation;
+    SpinnerPhase m_spinner;
+    qint64 m_lastFrameTime = 0;
+
+    // Ring style: geometry, colors, gradient stops and label suffix.
+    // Shared with every bar the same theme was applied to until edited.
+    CircularProgressTheme m_theme;
+    int m_styleBatch = 0;
+
+    // Cross-thread progress feed
+    std::atomic<int> m_feedValue{0};
+    std::atomic<quint64> m_feedPublished{0};
+    std::atomic<bool> m_feedSleeping{true};
+    quint64 m_feedSequence = 0;
+    quint64 m_feedConsumed = 0;
+    ProgressSource *m_source = nullptr;
+
+    // Cached static layer: background track and progress pens
+    QPixmap m_staticLayer;
+    QSize m_staticLayerSize;
+    qreal m_staticLayerDpr = 0;
+    QPen m_progressPen;
+    QPen m_highlightPen;
+    CircularProgressRenderer::FramePainter m_framePainter = nullptr;
+    CircularProgressLabelCache m_labelCache;
+    QRect m_textBounds;
+    QSharedPointer<SpinnerAtlas> m_spinnerAtlas;
+
+    // Only allocated in async raster mode, with the last requested state
+    QScopedPointer<ProgressRasterizer> m_rasterizer;
+    float m_rasterProgress = -1.0f;
+    int m_rasterAngle = 0;
+
+    // Quality policy and what it currently takes away; the style copy
+    // only exists while the gradient is dropped
+    qint8 m_qualityPin = -1;
+    quint8 m_allowedDegradations = ProgressQualityGovernor::AllDegradations;
+    quint8 m_degradations = 0;
+    QScopedPointer<CircularProgressStyle> m_degradedStyle;
 
-    // Color properties
-    QColor bg_color = QColor(20, 20, 20, 255);
-    QColor chunk_color = QColor(73, 139, 209);
-    QColor text_color = QColor(73, 139, 209);
-    QMap<qreal, QColor> gradient_colors;
+    // Only allocated while instrumentation is enabled
+    QScopedPointer<ProgressStats> m_stats;
 
     // Text properties
-    QString suffix = "%";
     Qt::Alignment textAlignment = Qt::AlignCenter;
     Qt::Alignment progressAlignment = Qt::AlignCenter;
 };
@@ -0,0 +1,95 @@
+#include "circularprogressdelegate.h"
+#include <QApplication>
+#include <QPainter>
+#include <QStyle>
+
+CircularProgressDelegate::CircularProgressDelegate(QObject *parent) : QStyledItemDelegate(parent) {
+}
+
+void CircularProgressDelegate::setProgressStyle(const CircularProgressStyle &style) {
+    m_style = style;
+    if (m_style.gradientTable.isEmpty())
+        m_style.gradientTable = CircularProgressRenderer::gradientTable(m_style.gradientColors);
+    m_trackCache = QPixmap();
+    m_penSize = QSize();
+    m_labelCache.clear();
+}
+
+void CircularProgressDelegate::setProgressRole(int role) {
+    m_progressRole = role;
+}
+
+void CircularProgressDelegate::setSpinnerAngle(int angle) {
+    m_spinnerAngle = angle;
+}
+
+const QPixmap &CircularProgressDelegate::track(const QSize &size, qreal dpr) const {
+    if (m_trackCache.isNull() || m_trackCache.size() != size * dpr
+        || !qFuzzyCompare(m_trackCache.devicePixelRatio(), dpr)) {
+        m_trackCache = QPixmap(size * dpr);
+        m_trackCache.setDevicePixelRatio(dpr);
+        m_trackCache.fill(Qt::transparent);
+
+        QPainter layer(&m_trackCache);
+        layer.setRenderHints(QPainter::Antialiasing);
+        CircularProgressRenderer::drawTrack(&layer,
+            CircularProgressRenderer::ringRect(QRect(QPoint(0, 0), size), m_style), m_style);
+    }
+    return m_trackCache;
+}
+
+void CircularProgressDelegate::ensurePens(const QSize &size, qreal dpr) const {
+    if (m_penSize == size && qFuzzyCompare(m_penDpr, dpr)) return;
+
+    QRect rect = CircularProgressRenderer::ringRect(QRect(QPoint(0, 0), size), m_style);
+    m_progressPen = CircularProgressRenderer::progressPen(m_style, rect, dpr);
+    m_highlightPen = CircularProgressRenderer::highlightPen(m_style);
+    m_penSize = size;
+    m_penDpr = dpr;
+}
+
+void CircularProgressDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option,
+                                     const QModelIndex &index) const {
+    QStyleOptionViewItem opt = option;
+    initStyleOption(&opt, index);
+
+    // Cell background and selection, the ring replaces the item text
+    const QWidget *widget = opt.widget;
+    QStyle *style = widget ? widget->style() : QApplication::style();
+    style->drawPrimitive(QStyle::PE_PanelItemViewItem, &opt, painter, widget);
+
+    int side = qMin(opt.rect.width(), opt.rect.height()) - 4;
+    if (side <= m_style.progressWidth) return;
+
+    QRect bounds(0, 0, side, side);
+    bounds.moveCenter(opt.rect.center());
+    // Everything is cached for a ring at the origin, so cells only translate
+    QRect rect = CircularProgressRenderer::ringRect(QRect(QPoint(0, 0), bounds.size()), m_style);
+    qreal dpr = painter->device()->devicePixelRatioF();
+    ensurePens(bounds.size(), dpr);
+
+    bool ok = false;
+    qreal progress = index.data(m_progressRole).toReal(&ok);
+    bool infinite = !ok || progress < 0;
+    progress = qBound<qreal>(0.0, progress, 1.0);
+
+    painter->save();
+    painter->setRenderHints(QPainter::Antialiasing);
+    painter->translate(bounds.topLeft());
+
+    if (m_style.backgroundEnabled) painter->drawPixmap(0, 0, track(bounds.size(), dpr));
+
+    const QStaticText *label = nullptr;
+    if (m_style.textEnabled && !infinite) {
+        painter->setFont(opt.font);
+        label = &m_labelCache.label(static_cast<int>(progress * 100), m_style.suffix, opt.font);
+    }
+    CircularProgressRenderer::drawFrame(painter, rect, m_style, m_progressPen, m_highlightPen, progress,
+                                        m_spinnerAngle, infinite, label);
+
+    painter->restore();
+}
+
+QSize CircularProgressDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const {
+    return QStyledItemDelegate::sizeHint(option, index).expandedTo(QSize(24, 24));
+}
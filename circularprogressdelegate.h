@@ -0,0 +1,49 @@
+#ifndef CIRCULARPROGRESSDELEGATE_H
+#define CIRCULARPROGRESSDELEGATE_H
+
+#include <QStyledItemDelegate>
+#include <QPixmap>
+#include "circularprogressrenderer.h"
+
+// Draws a progress ring in item view cells without creating any widget.
+// The model provides the progress as a fraction in 0..1 through progressRole();
+// rows without a valid or with a negative value are drawn as a spinner.
+class CircularProgressDelegate : public QStyledItemDelegate {
+    Q_OBJECT
+
+public:
+    explicit CircularProgressDelegate(QObject *parent = nullptr);
+
+    void setProgressStyle(const CircularProgressStyle &style);
+    const CircularProgressStyle &progressStyle() const { return m_style; }
+
+    void setProgressRole(int role);
+    int progressRole() const { return m_progressRole; }
+
+    // Views animate indeterminate rows by advancing this and updating the viewport
+    void setSpinnerAngle(int angle);
+    int spinnerAngle() const { return m_spinnerAngle; }
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+    QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+
+private:
+    const QPixmap &track(const QSize &size, qreal dpr) const;
+    // Pens for a ring of this size at the origin; cells translate to it
+    void ensurePens(const QSize &size, qreal dpr) const;
+
+    CircularProgressStyle m_style;
+    int m_progressRole = Qt::UserRole;
+    int m_spinnerAngle = 0;
+
+    // Rows usually share one size, so a single track pixmap covers the view
+    mutable QPixmap m_trackCache;
+    // Same for the pens, whose arc gradient texture is as costly as the track
+    mutable QSize m_penSize;
+    mutable qreal m_penDpr = 0;
+    mutable QPen m_progressPen;
+    mutable QPen m_highlightPen;
+    mutable CircularProgressLabelCache m_labelCache;
+};
+
+#endif // CIRCULARPROGRESSDELEGATE_H
@@ -0,0 +1,112 @@
+#include "circularprogressexporter.h"
+#include "progressanimation.h"
+#include <QImageWriter>
+#include <QPainter>
+#include <QtConcurrent>
+
+CircularProgressExporter::CircularProgressExporter(const CircularProgressTheme &theme) : m_theme(theme) {
+}
+
+QImage CircularProgressExporter::renderValue(qreal progress) const {
+    return render(layers(), qBound<qreal>(0.0, progress, 1.0), 0, false);
+}
+
+QImage CircularProgressExporter::renderSpinner(int startAngle) const {
+    return render(layers(), 0.0, startAngle, true);
+}
+
+int CircularProgressExporter::exportValues(const QVector<qreal> &values, const QString &fileNamePattern,
+                                           const QByteArray &format) const {
+    QVector<Job> jobs(values.size());
+    for (int i = 0; i < values.size(); ++i) {
+        jobs[i].index = i;
+        jobs[i].progress = qBound<qreal>(0.0, values.at(i), 1.0);
+    }
+    return exportJobs(jobs, fileNamePattern, format);
+}
+
+int CircularProgressExporter::exportSpinnerCycle(const QString &fileNamePattern, const QByteArray &format) const {
+    // Same direction as the on-screen spinner: start angles count down
+    QVector<Job> jobs(360 / SpinnerPhase::Step);
+    for (int i = 0; i < jobs.size(); ++i) {
+        jobs[i].index = i;
+        jobs[i].startAngle = (360 - i * SpinnerPhase::Step) % 360;
+        jobs[i].infinite = true;
+    }
+    return exportJobs(jobs, fileNamePattern, format);
+}
+
+CircularProgressExporter::Layers CircularProgressExporter::layers() const {
+    const CircularProgressStyle &style = m_theme.style();
+
+    // Geometry of a bar this size with its default square, centered ring
+    int side = qMin(m_size.width(), m_size.height());
+    Layers result;
+    result.origin = QPoint((m_size.width() - side) / 2, (m_size.height() - side) / 2);
+    QRect bounds(result.origin, QSize(side, side));
+    if (style.shadow) {
+        int margin = CircularProgressRenderer::shadowMargin(style);
+        bounds.adjust(margin, margin, -margin, -margin);
+    }
+    result.ringRect = CircularProgressRenderer::ringRect(bounds, style);
+    result.progressPen = CircularProgressRenderer::progressPen(style, result.ringRect, m_dpr);
+    result.highlightPen = CircularProgressRenderer::highlightPen(style);
+
+    // Shadow and track layer exactly like CircularProgressBar::ensureStaticLayer(),
+    // as an image because pixmaps can't be used outside the GUI thread
+    if ((style.backgroundEnabled || style.shadow) && side > 0) {
+        result.track = QImage(QSize(side, side) * m_dpr, QImage::Format_ARGB32_Premultiplied);
+        result.track.setDevicePixelRatio(m_dpr);
+        result.track.fill(Qt::transparent);
+
+        QPainter layer(&result.track);
+        layer.setRenderHints(QPainter::Antialiasing);
+        QRect ring = result.ringRect.translated(-result.origin);
+        if (style.shadow)
+            layer.drawImage(0, 0, CircularProgressRenderer::shadowImage(QSize(side, side), m_dpr, ring, style));
+        if (style.backgroundEnabled) CircularProgressRenderer::drawTrack(&layer, ring, style);
+    }
+    return result;
+}
+
+QImage CircularProgressExporter::render(const Layers &layers, qreal progress, int startAngle, bool infinite) const {
+    const CircularProgressStyle &style = m_theme.style();
+
+    QImage image(m_size * m_dpr, QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(m_dpr);
+    image.fill(m_background);
+
+    QPainter painter(&image);
+    painter.setRenderHints(QPainter::Antialiasing);
+    if (!layers.track.isNull()) painter.drawImage(layers.origin, layers.track);
+
+    // Shaped per frame: label caches are not shared between worker threads
+    CircularProgressLabelCache labels;
+    const QStaticText *label = style.textEnabled && !infinite
+        ? &labels.label(static_cast<int>(progress * 100), style.suffix, m_font) : nullptr;
+    CircularProgressRenderer::drawFrame(&painter, layers.ringRect, style, layers.progressPen, layers.highlightPen,
+                                        progress, startAngle, infinite, label);
+    painter.end();
+    return image;
+}
+
+int CircularProgressExporter::exportJobs(QVector<Job> &jobs, const QString &fileNamePattern,
+                                         const QByteArray &format) const {
+    if (jobs.isEmpty()) return 0;
+
+    // Layers are built once and only read by the workers
+    const Layers shared = layers();
+    const int digits = qMax(4, QString::number(jobs.size() - 1).size());
+
+    QtConcurrent::blockingMap(jobs, [&](Job &job) {
+        QImage image = render(shared, job.progress, job.startAngle, job.infinite);
+        QImageWriter writer(fileNamePattern.arg(job.index, digits, 10, QChar('0')), format);
+        job.written = writer.write(image);
+    });
+
+    int written = 0;
+    for (const Job &job : jobs) {
+        if (job.written) ++written;
+    }
+    return written;
+}
@@ -0,0 +1,81 @@
+#ifndef CIRCULARPROGRESSEXPORTER_H
+#define CIRCULARPROGRESSEXPORTER_H
+
+#include <QByteArray>
+#include <QColor>
+#include <QFont>
+#include <QImage>
+#include <QPen>
+#include <QSize>
+#include <QString>
+#include <QVector>
+#include "circularprogressrenderer.h"
+
+// Renders rings to images without a display, e.g. for reports and docs.
+// Frames go through the same layers and drawing calls as
+// CircularProgressBar::paintEvent(), so a bar of the same size, device pixel
+// ratio, font and theme (with the default square, centered ring) paints the
+// same pixels.
+//
+// Batch exports fan frames out over QThreadPool::globalInstance() and write
+// each one as soon as it is rendered, so at most one image per worker is in
+// memory regardless of the sequence length.
+class CircularProgressExporter {
+public:
+    explicit CircularProgressExporter(const CircularProgressTheme &theme = CircularProgressTheme());
+
+    void setTheme(const CircularProgressTheme &theme) { m_theme = theme; }
+    const CircularProgressTheme &theme() const { return m_theme; }
+
+    // Image size in device independent pixels
+    void setSize(const QSize &size) { m_size = size; }
+    QSize size() const { return m_size; }
+    void setDevicePixelRatio(qreal dpr) { m_dpr = qMax<qreal>(0.1, dpr); }
+    qreal devicePixelRatio() const { return m_dpr; }
+    // Pass the bar's font() to match its label
+    void setFont(const QFont &font) { m_font = font; }
+    QFont font() const { return m_font; }
+    void setBackground(const QColor &color) { m_background = color; }
+    QColor background() const { return m_background; }
+
+    // progress is 0..1, startAngle is the spinner's angle in degrees
+    QImage renderValue(qreal progress) const;
+    QImage renderSpinner(int startAngle) const;
+
+    // %1 in fileNamePattern becomes the zero-padded frame index.
+    // Both return the number of frames written.
+    int exportValues(const QVector<qreal> &values, const QString &fileNamePattern,
+                     const QByteArray &format = "png") const;
+    // One full turn of the spinner in its 6° steps
+    int exportSpinnerCycle(const QString &fileNamePattern, const QByteArray &format = "png") const;
+
+private:
+    // Everything that stays the same across the frames of one export
+    struct Layers {
+        QRect ringRect;
+        QPoint origin;
+        QImage track;
+        QPen progressPen;
+        QPen highlightPen;
+    };
+
+    struct Job {
+        int index = 0;
+        qreal progress = 0;
+        int startAngle = 0;
+        bool infinite = false;
+        bool written = false;
+    };
+
+    Layers layers() const;
+    QImage render(const Layers &layers, qreal progress, int startAngle, bool infinite) const;
+    int exportJobs(QVector<Job> &jobs, const QString &fileNamePattern, const QByteArray &format) const;
+
+    CircularProgressTheme m_theme;
+    QSize m_size = QSize(100, 100);
+    qreal m_dpr = 1.0;
+    QFont m_font;
+    QColor m_background = Qt::transparent;
+};
+
+#endif // CIRCULARPROGRESSEXPORTER_H
@@ -0,0 +1,509 @@
+#include "circularprogressitem.h"
+#include <QPainter>
+#include <QQmlEngine>
+#include <QQuickWindow>
+#include <QSGGeometryNode>
+#include <QSGRenderNode>
+#include <QSGRendererInterface>
+#include <QSGTransformNode>
+#include <QSGVertexColorMaterial>
+#include <QtMath>
+#include <cmath>
+
+namespace {
+
+// Solid color or one of the widget's gradient layouts, looked up in the style's table
+struct ArcColors {
+    QColor solid;
+    bool gradient = false;
+    CircularProgressStyle::GradientMode mode = CircularProgressStyle::LinearGradient;
+    QVector<QRgb> table;
+    QPointF start;
+    QPointF finalStop;
+    qreal sweep = 360;
+
+    QColor at(const QPointF &point, qreal angle) const {
+        if (!gradient) return solid;
+
+        qreal t = mode == CircularProgressStyle::LinearGradient
+                      ? position(point) : CircularProgressRenderer::arcGradientPosition(angle, sweep);
+        return QColor::fromRgba(CircularProgressRenderer::gradientColor(table, t));
+    }
+
+    qreal position(const QPointF &point) const {
+        QPointF axis = finalStop - start;
+        qreal length = QPointF::dotProduct(axis, axis);
+        if (qFuzzyIsNull(length)) return 0.0;
+        return qBound<qreal>(0.0, QPointF::dotProduct(point - start, axis) / length, 1.0);
+    }
+};
+
+void setVertex(QSGGeometry::ColoredPoint2D &vertex, const QPointF &point, qreal angle, const ArcColors &colors) {
+    // QSGVertexColorMaterial expects premultiplied colors
+    QColor c = colors.at(point, angle);
+    qreal a = c.alphaF();
+    vertex.set(point.x(), point.y(),
+               uchar(qRound(c.red() * a)), uchar(qRound(c.green() * a)),
+               uchar(qRound(c.blue() * a)), uchar(c.alpha()));
+}
+
+// Triangles for a stroked arc of the ring. Angles are in degrees, clockwise
+// from 12 o'clock, matching what QPainter::drawArc() produces for the widget.
+void buildArc(QSGGeometry *geometry, const QRect &ring, qreal penWidth,
+              qreal startDeg, qreal spanDeg, bool roundCap, const ArcColors &colors) {
+    if (qFuzzyIsNull(spanDeg) || ring.isEmpty()) {
+        geometry->allocate(0);
+        return;
+    }
+
+    const QPointF center = QRectF(ring).center();
+    const qreal rx = ring.width() / 2.0;
+    const qreal ry = ring.height() / 2.0;
+    const qreal half = penWidth / 2.0;
+
+    // Square caps extend the stroke by half the pen along the tangent
+    if (!roundCap) {
+        qreal extend = qRadiansToDegrees(half / qMax<qreal>(1.0, qMin(rx, ry)));
+        qreal direction = spanDeg > 0 ? 1.0 : -1.0;
+        startDeg -= extend * direction;
+        spanDeg += 2 * extend * direction;
+    }
+
+    auto pointAt = [&](qreal deg, qreal offset) {
+        qreal rad = qDegreesToRadians(deg);
+        return QPointF(center.x() + (rx + offset) * qSin(rad), center.y() - (ry + offset) * qCos(rad));
+    };
+
+    const int segments = qMax(1, qCeil(std::abs(spanDeg) / 2.0));
+    const int capSegments = roundCap ? 8 : 0;
+    geometry->allocate(segments * 6 + capSegments * 3 * 2);
+    QSGGeometry::ColoredPoint2D *v = geometry->vertexDataAsColoredPoint2D();
+
+    for (int i = 0; i < segments; ++i) {
+        qreal a0 = startDeg + spanDeg * i / segments;
+        qreal a1 = startDeg + spanDeg * (i + 1) / segments;
+        QPointF inner0 = pointAt(a0, -half), outer0 = pointAt(a0, half);
+        QPointF inner1 = pointAt(a1, -half), outer1 = pointAt(a1, half);
+        setVertex(*v++, inner0, a0, colors);
+        setVertex(*v++, outer0, a0, colors);
+        setVertex(*v++, inner1, a1, colors);
+        setVertex(*v++, outer0, a0, colors);
+        setVertex(*v++, outer1, a1, colors);
+        setVertex(*v++, inner1, a1, colors);
+    }
+
+    // Half discs at both ends, facing away from the arc
+    const qreal direction = spanDeg > 0 ? 1.0 : -1.0;
+    for (int end = 0; end < (roundCap ? 2 : 0); ++end) {
+        qreal deg = end == 0 ? startDeg : startDeg + spanDeg;
+        qreal rad = qDegreesToRadians(deg);
+        QPointF normal(qSin(rad), -qCos(rad));
+        QPointF tangent(qCos(rad), qSin(rad));
+        QPointF outward = tangent * (end == 0 ? -direction : direction);
+        QPointF capCenter = pointAt(deg, 0);
+
+        for (int i = 0; i < capSegments; ++i) {
+            qreal p0 = M_PI * i / capSegments;
+            qreal p1 = M_PI * (i + 1) / capSegments;
+            setVertex(*v++, capCenter, deg, colors);
+            setVertex(*v++, capCenter + half * (normal * qCos(p0) + outward * qSin(p0)), deg, colors);
+            setVertex(*v++, capCenter + half * (normal * qCos(p1) + outward * qSin(p1)), deg, colors);
+        }
+    }
+}
+
+QSGGeometryNode *createArcNode() {
+    auto *geometry = new QSGGeometry(QSGGeometry::defaultAttributes_ColoredPoint2D(), 0);
+    geometry->setDrawingMode(QSGGeometry::DrawTriangles);
+
+    auto *node = new QSGGeometryNode;
+    node->setGeometry(geometry);
+    node->setFlag(QSGNode::OwnsGeometry);
+    node->setMaterial(new QSGVertexColorMaterial);
+    node->setFlag(QSGNode::OwnsMaterial);
+    return node;
+}
+
+// Scene-graph tree for hardware backends: track, and the arc under a rotation
+class RingNode : public QSGNode {
+public:
+    RingNode() {
+        track = createArcNode();
+        rotation = new QSGTransformNode;
+        arc = createArcNode();
+        appendChildNode(track);
+        appendChildNode(rotation);
+        rotation->appendChildNode(arc);
+    }
+
+    QSGGeometryNode *track = nullptr;
+    QSGTransformNode *rotation = nullptr;
+    QSGGeometryNode *arc = nullptr;
+};
+
+// The software adaptation has no custom geometry support, it paints instead
+class PainterRingNode : public QSGRenderNode {
+public:
+    explicit PainterRingNode(QQuickWindow *window) : m_window(window) {}
+
+    void render(const RenderState *state) override {
+        QSGRendererInterface *rif = m_window->rendererInterface();
+        auto *painter = static_cast<QPainter *>(rif->getResource(m_window, QSGRendererInterface::PainterResource));
+        if (!painter) return;
+
+        // The clip must be set before the transform
+        const QRegion *clipRegion = state->clipRegion();
+        if (clipRegion && !clipRegion->isEmpty())
+            painter->setClipRegion(*clipRegion, Qt::ReplaceClip);
+
+        painter->setTransform(matrix()->toTransform());
+        painter->setOpacity(inheritedOpacity());
+
+        // Arc gradient textures are only rebuilt when the ring changes
+        qreal dpr = painter->device()->devicePixelRatioF();
+        if (pensDirty || !qFuzzyCompare(m_penDpr, dpr)) {
+            m_ring = CircularProgressRenderer::ringRect(bounds, style);
+            m_progressPen = CircularProgressRenderer::progressPen(style, m_ring, dpr);
+            m_highlightPen = CircularProgressRenderer::highlightPen(style);
+            m_penDpr = dpr;
+            pensDirty = false;
+        }
+
+        painter->save();
+        painter->setRenderHints(QPainter::Antialiasing);
+        if (style.backgroundEnabled) CircularProgressRenderer::drawTrack(painter, m_ring, style);
+        CircularProgressRenderer::drawFrame(painter, m_ring, style, m_progressPen, m_highlightPen, progress,
+                                            startAngle, infinite, nullptr);
+        painter->restore();
+    }
+
+    StateFlags changedStates() const override { return StateFlags(); }
+    RenderingFlags flags() const override { return BoundedRectRendering; }
+    QRectF rect() const override { return bounds; }
+
+    QRect bounds;
+    CircularProgressStyle style;
+    qreal progress = 0;
+    int startAngle = 0;
+    bool infinite = false;
+    // Set whenever bounds or style change
+    bool pensDirty = true;
+
+private:
+    QQuickWindow *m_window = nullptr;
+    QRect m_ring;
+    QPen m_progressPen;
+    QPen m_highlightPen;
+    qreal m_penDpr = 0;
+};
+
+}
+
+CircularProgressItem::CircularProgressItem(QQuickItem *parent) : QQuickItem(parent) {
+    setFlag(ItemHasContents, true);
+    // Labels belong to QML, not to the ring
+    m_style.textEnabled = false;
+    m_style.gradientTable = CircularProgressRenderer::gradientTable(m_style.gradientColors);
+}
+
+CircularProgressItem::~CircularProgressItem() {
+    if (m_registered) ProgressAnimationDriver::instance()->unregisterClient(this);
+}
+
+void CircularProgressItem::registerType(const char *uri, int versionMajor, int versionMinor) {
+    qmlRegisterType<CircularProgressItem>(uri, versionMajor, versionMinor, "CircularProgressRing");
+}
+
+QVariantMap CircularProgressItem::gradientStops() const {
+    QVariantMap stops;
+    for (auto it = m_style.gradientColors.begin(); it != m_style.gradientColors.end(); ++it)
+        stops.insert(QString::number(it.key()), it.value());
+    return stops;
+}
+
+void CircularProgressItem::setValue(qreal value) {
+    value = qBound(m_from, value, m_to);
+    if (qFuzzyCompare(m_value, value)) return;
+
+    m_value = value;
+    emit valueChanged(m_value);
+    if (!m_infiniteLoop) updateProgressAnimation();
+}
+
+void CircularProgressItem::setFrom(qreal from) {
+    if (qFuzzyCompare(m_from, from)) return;
+
+    m_from = from;
+    emit rangeChanged();
+    setInfiniteLoop(m_to <= m_from);
+    if (!m_infiniteLoop) updateProgressAnimation();
+}
+
+void CircularProgressItem::setTo(qreal to) {
+    if (qFuzzyCompare(m_to, to)) return;
+
+    m_to = to;
+    emit rangeChanged();
+    setInfiniteLoop(m_to <= m_from);
+    if (!m_infiniteLoop) updateProgressAnimation();
+}
+
+void CircularProgressItem::setInfiniteLoop(bool loop) {
+    if (m_infiniteLoop == loop) return;
+
+    m_infiniteLoop = loop;
+    if (m_infiniteLoop) {
+        m_valueAnimation.stop();
+        m_startAngle = m_spinner.angleAt(ProgressAnimationDriver::instance()->elapsed());
+    } else {
+        updateProgressAnimation();
+    }
+    m_arcDirty = true;
+    update();
+    updateScheduling();
+    emit modeChanged(m_infiniteLoop);
+}
+
+void CircularProgressItem::setStartAngle(int angle) {
+    if (m_startAngle == angle) return;
+
+    m_startAngle = angle;
+    update();
+    emit startAngleChanged(angle);
+}
+
+void CircularProgressItem::setAnimationProgress(float progress) {
+    if (m_animationProgress == progress) return;
+
+    m_animationProgress = progress;
+    m_arcDirty = true;
+    update();
+    emit animationProgressChanged(progress);
+}
+
+void CircularProgressItem::setAnimationThreshold(float threshold) {
+    m_threshold = threshold;
+    emit styleChanged();
+}
+
+void CircularProgressItem::setDuration(int duration) {
+    m_spinner.setDuration(duration);
+    emit styleChanged();
+}
+
+void CircularProgressItem::setChunkLength(double length) {
+    m_style.chunkLength = length;
+    markStyleDirty();
+}
+
+void CircularProgressItem::setCircularDegree(int degree) {
+    m_style.circularDegree = degree;
+    markStyleDirty();
+}
+
+void CircularProgressItem::setProgressWidth(int width) {
+    m_style.progressWidth = width;
+    markStyleDirty();
+}
+
+void CircularProgressItem::setRoundedCap(bool enable) {
+    m_style.roundedCap = enable;
+    markStyleDirty();
+}
+
+void CircularProgressItem::setBackgroundEnabled(bool enable) {
+    m_style.backgroundEnabled = enable;
+    markStyleDirty();
+}
+
+void CircularProgressItem::setBackgroundColor(const QColor &color) {
+    m_style.backgroundColor = color;
+    markStyleDirty();
+}
+
+void CircularProgressItem::setChunkColor(const QColor &color) {
+    m_style.chunkColor = color;
+    markStyleDirty();
+}
+
+void CircularProgressItem::setGradient(bool enable) {
+    m_style.gradient = enable;
+    markStyleDirty();
+}
+
+void CircularProgressItem::setGradientStops(const QVariantMap &stops) {
+    QMap<qreal, QColor> map;
+    for (auto it = stops.begin(); it != stops.end(); ++it)
+        map.insert(it.key().toDouble(), it.value().value<QColor>());
+    m_style.gradientColors = map;
+    m_style.gradientTable = CircularProgressRenderer::gradientTable(map);
+    markStyleDirty();
+}
+
+void CircularProgressItem::setGradientMode(int mode) {
+    m_style.gradientMode = static_cast<CircularProgressStyle::GradientMode>(
+        qBound<int>(CircularProgressStyle::LinearGradient, mode, CircularProgressStyle::FilledArcGradient));
+    markStyleDirty();
+}
+
+void CircularProgressItem::setProgressStyle(const CircularProgressStyle &style) {
+    m_style = style;
+    m_style.textEnabled = false;
+    if (m_style.gradientTable.isEmpty())
+        m_style.gradientTable = CircularProgressRenderer::gradientTable(m_style.gradientColors);
+    markStyleDirty();
+}
+
+void CircularProgressItem::markStyleDirty() {
+    m_styleDirty = true;
+    update();
+    emit styleChanged();
+}
+
+float CircularProgressItem::targetProgress() const {
+    qreal range = m_to - m_from;
+    return range > 0 ? static_cast<float>((m_value - m_from) / range) : 0.0f;
+}
+
+void CircularProgressItem::updateProgressAnimation() {
+    // Same rule as CircularProgressBar::updateProgressAnimation()
+    float target = targetProgress();
+    float delta = std::abs(target - m_animationProgress);
+
+    if (m_value >= m_to || delta >= m_threshold) {
+        m_valueAnimation.start(m_animationProgress, target);
+        updateScheduling();
+    }
+}
+
+void CircularProgressItem::updateScheduling() {
+    bool needsTicks = (m_infiniteLoop || m_valueAnimation.isRunning()) && isVisible() && window();
+    if (needsTicks == m_registered) return;
+
+    ProgressAnimationDriver *driver = ProgressAnimationDriver::instance();
+    m_registered = needsTicks;
+    if (m_registered) {
+        m_lastFrameTime = driver->elapsed();
+        driver->registerClient(this);
+    } else {
+        driver->unregisterClient(this);
+    }
+}
+
+void CircularProgressItem::advanceAnimation(qint64 frameTime) {
+    qint64 delta = qMax<qint64>(0, frameTime - m_lastFrameTime);
+    m_lastFrameTime = frameTime;
+
+    if (m_infiniteLoop) {
+        setStartAngle(m_spinner.angleAt(frameTime));
+    } else if (m_valueAnimation.isRunning()) {
+        setAnimationProgress(m_valueAnimation.advance(delta));
+        if (!m_valueAnimation.isRunning()) updateScheduling();
+    }
+}
+
+void CircularProgressItem::itemChange(ItemChange change, const ItemChangeData &value) {
+    QQuickItem::itemChange(change, value);
+    if (change == ItemVisibleHasChanged || change == ItemSceneChange) updateScheduling();
+}
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+void CircularProgressItem::geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry) {
+    QQuickItem::geometryChange(newGeometry, oldGeometry);
+    if (newGeometry.size() != oldGeometry.size()) markStyleDirty();
+}
+#else
+void CircularProgressItem::geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry) {
+    QQuickItem::geometryChanged(newGeometry, oldGeometry);
+    if (newGeometry.size() != oldGeometry.size()) markStyleDirty();
+}
+#endif
+
+QSGNode *CircularProgressItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) {
+    Q_UNUSED(data);
+
+    // Square ring centered in the item, like the widget's default
+    int side = qFloor(qMin(width(), height()));
+    if (side <= m_style.progressWidth) {
+        delete oldNode;
+        return nullptr;
+    }
+    QRect bounds(0, 0, side, side);
+    bounds.moveCenter(boundingRect().center().toPoint());
+
+    QQuickWindow *win = window();
+    if (win && win->rendererInterface()->graphicsApi() == QSGRendererInterface::Software) {
+        auto *node = static_cast<PainterRingNode *>(oldNode);
+        if (!node) node = new PainterRingNode(win);
+        if (m_styleDirty || node->bounds != bounds) {
+            node->bounds = bounds;
+            node->style = m_style;
+            node->pensDirty = true;
+            m_styleDirty = false;
+        }
+        node->progress = m_animationProgress;
+        node->startAngle = m_startAngle;
+        node->infinite = m_infiniteLoop;
+        node->markDirty(QSGNode::DirtyMaterial);
+        return node;
+    }
+
+    auto *node = static_cast<RingNode *>(oldNode);
+    if (!node) {
+        node = new RingNode;
+        m_styleDirty = true;
+    }
+
+    const QRect ring = CircularProgressRenderer::ringRect(bounds, m_style);
+
+    if (m_styleDirty) {
+        ArcColors trackColors;
+        trackColors.solid = m_style.backgroundColor;
+        buildArc(node->track->geometry(), ring, m_style.progressWidth, 0,
+                 m_style.backgroundEnabled ? m_style.circularDegree : 0, m_style.roundedCap, trackColors);
+        node->track->markDirty(QSGNode::DirtyGeometry);
+        m_arcDirty = true;
+    }
+
+    ArcColors colors;
+    colors.solid = m_style.chunkColor;
+    colors.gradient = m_style.gradient;
+    colors.start = ring.topLeft();
+    colors.finalStop = ring.bottomRight();
+    colors.mode = m_style.gradientMode;
+    colors.table = m_style.gradientTable;
+    colors.sweep = m_style.circularDegree;
+
+    QMatrix4x4 matrix;
+    if (m_infiniteLoop) {
+        // A solid chunk never changes shape, spinning only moves the transform.
+        // Gradients are fixed to the item, so those chunks are rebuilt instead.
+        bool rotate = !m_style.gradient;
+        if (m_arcDirty || !rotate) {
+            buildArc(node->arc->geometry(), ring, m_style.progressWidth, rotate ? 0 : -m_startAngle,
+                     m_style.chunkLength, m_style.roundedCap, colors);
+            node->arc->markDirty(QSGNode::DirtyGeometry);
+        }
+        if (rotate) {
+            QPointF c = QRectF(ring).center();
+            matrix.translate(c.x(), c.y());
+            matrix.rotate(-m_startAngle, 0, 0, 1);
+            matrix.translate(-c.x(), -c.y());
+        }
+    } else if (m_arcDirty) {
+        if (m_animationProgress > m_style.highlightThreshold) {
+            colors.gradient = false;
+            colors.solid = m_style.highlightColor;
+        }
+        if (m_style.gradientMode == CircularProgressStyle::FilledArcGradient)
+            colors.sweep = m_animationProgress * m_style.circularDegree;
+        buildArc(node->arc->geometry(), ring, m_style.progressWidth, 0,
+                 m_animationProgress * m_style.circularDegree, m_style.roundedCap, colors);
+        node->arc->markDirty(QSGNode::DirtyGeometry);
+    }
+    node->rotation->setMatrix(matrix);
+
+    m_styleDirty = false;
+    m_arcDirty = false;
+    return node;
+}
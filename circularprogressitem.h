@@ -0,0 +1,128 @@
+#ifndef CIRCULARPROGRESSITEM_H
+#define CIRCULARPROGRESSITEM_H
+
+#include <QQuickItem>
+#include <QVariantMap>
+#include "circularprogressrenderer.h"
+#include "progressanimation.h"
+#include "progressanimationdriver.h"
+
+// Qt Quick counterpart of CircularProgressBar.
+// Renders through scene-graph geometry: the track is built once per style or
+// size, value changes only rebuild the progress arc and spinner frames only
+// touch a transform node. With the software adaptation the ring is painted
+// by CircularProgressRenderer instead. Labels are left to a QML Text item.
+class CircularProgressItem : public QQuickItem, private ProgressAnimationClient {
+    Q_OBJECT
+    Q_PROPERTY(qreal value READ value WRITE setValue NOTIFY valueChanged)
+    Q_PROPERTY(qreal from READ from WRITE setFrom NOTIFY rangeChanged)
+    Q_PROPERTY(qreal to READ to WRITE setTo NOTIFY rangeChanged)
+    Q_PROPERTY(bool infiniteLoop READ isInfiniteLoop WRITE setInfiniteLoop NOTIFY modeChanged)
+    Q_PROPERTY(int startAngle READ startAngle WRITE setStartAngle NOTIFY startAngleChanged)
+    Q_PROPERTY(float animationProgress READ animationProgress WRITE setAnimationProgress NOTIFY animationProgressChanged)
+    Q_PROPERTY(float animationThreshold READ animationThreshold WRITE setAnimationThreshold NOTIFY styleChanged)
+    Q_PROPERTY(int duration READ duration WRITE setDuration NOTIFY styleChanged)
+    Q_PROPERTY(double chunkLength READ chunkLength WRITE setChunkLength NOTIFY styleChanged)
+    Q_PROPERTY(int circularDegree READ circularDegree WRITE setCircularDegree NOTIFY styleChanged)
+    Q_PROPERTY(int progressWidth READ progressWidth WRITE setProgressWidth NOTIFY styleChanged)
+    Q_PROPERTY(bool roundedCap READ hasRoundedCap WRITE setRoundedCap NOTIFY styleChanged)
+    Q_PROPERTY(bool backgroundEnabled READ isBackgroundEnabled WRITE setBackgroundEnabled NOTIFY styleChanged)
+    Q_PROPERTY(QColor backgroundColor READ backgroundColor WRITE setBackgroundColor NOTIFY styleChanged)
+    Q_PROPERTY(QColor chunkColor READ chunkColor WRITE setChunkColor NOTIFY styleChanged)
+    Q_PROPERTY(bool gradient READ hasGradient WRITE setGradient NOTIFY styleChanged)
+    // 0 linear, 1 along the ring, 2 along the filled part, see CircularProgressStyle::GradientMode
+    Q_PROPERTY(int gradientMode READ gradientMode WRITE setGradientMode NOTIFY styleChanged)
+    Q_PROPERTY(QVariantMap gradientStops READ gradientStops WRITE setGradientStops NOTIFY styleChanged)
+
+public:
+    explicit CircularProgressItem(QQuickItem *parent = nullptr);
+    ~CircularProgressItem();
+
+    // Registers the item as CircularProgressRing in the given QML module
+    static void registerType(const char *uri = "CircularProgress", int versionMajor = 1, int versionMinor = 0);
+
+    qreal value() const { return m_value; }
+    qreal from() const { return m_from; }
+    qreal to() const { return m_to; }
+    bool isInfiniteLoop() const { return m_infiniteLoop; }
+    int startAngle() const { return m_startAngle; }
+    float animationProgress() const { return m_animationProgress; }
+    float animationThreshold() const { return m_threshold; }
+    int duration() const { return m_spinner.duration(); }
+    double chunkLength() const { return m_style.chunkLength; }
+    int circularDegree() const { return m_style.circularDegree; }
+    int progressWidth() const { return m_style.progressWidth; }
+    bool hasRoundedCap() const { return m_style.roundedCap; }
+    bool isBackgroundEnabled() const { return m_style.backgroundEnabled; }
+    QColor backgroundColor() const { return m_style.backgroundColor; }
+    QColor chunkColor() const { return m_style.chunkColor; }
+    bool hasGradient() const { return m_style.gradient; }
+    int gradientMode() const { return m_style.gradientMode; }
+    QVariantMap gradientStops() const;
+    const CircularProgressStyle &progressStyle() const { return m_style; }
+
+    void setValue(qreal value);
+    void setFrom(qreal from);
+    void setTo(qreal to);
+    void setInfiniteLoop(bool loop);
+    void setStartAngle(int angle);
+    void setAnimationProgress(float progress);
+    void setAnimationThreshold(float threshold);
+    void setDuration(int duration);
+    void setChunkLength(double length);
+    void setCircularDegree(int degree);
+    void setProgressWidth(int width);
+    void setRoundedCap(bool enable);
+    void setBackgroundEnabled(bool enable);
+    void setBackgroundColor(const QColor &color);
+    void setChunkColor(const QColor &color);
+    void setGradient(bool enable);
+    void setGradientMode(int mode);
+    // Keys are stop positions in 0..1, values anything QColor accepts
+    void setGradientStops(const QVariantMap &stops);
+    void setProgressStyle(const CircularProgressStyle &style);
+
+signals:
+    void valueChanged(qreal value);
+    void rangeChanged();
+    void modeChanged(bool isInfinite);
+    void startAngleChanged(int angle);
+    void animationProgressChanged(float progress);
+    void styleChanged();
+
+protected:
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) override;
+    void itemChange(ItemChange change, const ItemChangeData &value) override;
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    void geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry) override;
+#else
+    void geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry) override;
+#endif
+
+private:
+    void advanceAnimation(qint64 frameTime) override;
+    void updateScheduling();
+    void updateProgressAnimation();
+    void markStyleDirty();
+    float targetProgress() const;
+
+    CircularProgressStyle m_style;
+    qreal m_value = 0;
+    qreal m_from = 0;
+    qreal m_to = 100;
+    bool m_infiniteLoop = false;
+    int m_startAngle = 0;
+    float m_animationProgress = 0.0f;
+    float m_threshold = 0.02f;
+
+    ProgressValueAnimation m_valueAnimation;
+    SpinnerPhase m_spinner;
+    qint64 m_lastFrameTime = 0;
+    bool m_registered = false;
+
+    // What updatePaintNode() has to rebuild
+    bool m_styleDirty = true;
+    bool m_arcDirty = true;
+};
+
+#endif // CIRCULARPROGRESSITEM_H
@@ -0,0 +1,495 @@
+#include "circularprogressrenderer.h"
+#include "arcrasterizer.h"
+#include <QCache>
+#include <QConicalGradient>
+#include <QImage>
+#include <QLinearGradient>
+#include <QMutex>
+#include <QtMath>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Read by rasterizer workers while the GUI thread may switch it
+std::atomic<int> g_arcBackend{CircularProgressRenderer::PathStroker};
+
+// painter->drawArc() with the current pen, through the selected backend
+void strokeArc(QPainter *painter, const QRect &rect, int startAngle, int spanAngle) {
+    if (g_arcBackend.load(std::memory_order_relaxed) == CircularProgressRenderer::AnalyticArcs
+        && ArcRasterizer::drawArc(painter, rect, startAngle, spanAngle)) {
+        return;
+    }
+    painter->drawArc(rect, startAngle, spanAngle);
+}
+
+QVector<QRgb> tableFor(const CircularProgressStyle &style) {
+    return style.gradientTable.isEmpty() ? CircularProgressRenderer::gradientTable(style.gradientColors)
+                                         : style.gradientTable;
+}
+
+// The arc gradient is rendered once into a texture covering the stroke, so
+// stroking with it costs about as much as a solid pen. Texels are device
+// pixels, the brush transform maps them back to logical coordinates.
+QBrush arcTextureBrush(const CircularProgressStyle &style, const QRect &ringRect, qreal dpr) {
+    const QVector<QRgb> table = tableFor(style);
+    int pad = style.progressWidth / 2 + 2;
+    QRect area = ringRect.adjusted(-pad, -pad, pad, pad);
+    if (area.isEmpty()) return QBrush(style.chunkColor);
+
+    QImage texture(area.size() * dpr, QImage::Format_ARGB32_Premultiplied);
+    QPointF center = QRectF(ringRect).center() - area.topLeft();
+    qreal rx = qMax<qreal>(1.0, ringRect.width() / 2.0);
+    qreal ry = qMax<qreal>(1.0, ringRect.height() / 2.0);
+
+    for (int y = 0; y < texture.height(); ++y) {
+        QRgb *line = reinterpret_cast<QRgb *>(texture.scanLine(y));
+        qreal dy = ((y + 0.5) / dpr - center.y()) / ry;
+        for (int x = 0; x < texture.width(); ++x) {
+            qreal dx = ((x + 0.5) / dpr - center.x()) / rx;
+            qreal angle = qRadiansToDegrees(std::atan2(dx, -dy));
+            qreal position = CircularProgressRenderer::arcGradientPosition(angle, style.circularDegree);
+            line[x] = qPremultiply(CircularProgressRenderer::gradientColor(table, position));
+        }
+    }
+
+    QBrush brush(texture);
+    brush.setTransform(QTransform::fromScale(1 / dpr, 1 / dpr) * QTransform::fromTranslate(area.x(), area.y()));
+    return brush;
+}
+
+// One box pass along rows: a sliding sum over 2 * radius + 1 pixels,
+// with pixels outside the buffer counting as transparent
+void boxBlurRows(uchar *alpha, int width, int height, int radius, uchar *line) {
+    const quint32 scale = (1u << 16) / (2 * radius + 1);
+    for (int y = 0; y < height; ++y) {
+        uchar *row = alpha + y * width;
+        memcpy(line, row, width);
+        quint32 sum = 0;
+        for (int x = 0; x < qMin(radius, width); ++x) sum += line[x];
+        for (int x = 0; x < width; ++x) {
+            if (x + radius < width) sum += line[x + radius];
+            row[x] = uchar((sum * scale + (1u << 15)) >> 16);
+            if (x - radius >= 0) sum -= line[x - radius];
+        }
+    }
+}
+
+// The same pass along columns, a whole row at a time so the inner loops run
+// over contiguous memory and vectorize
+void boxBlurColumns(uchar *alpha, int width, int height, int radius, QVector<uchar> &source, QVector<quint32> &sums) {
+    const quint32 scale = (1u << 16) / (2 * radius + 1);
+    memcpy(source.data(), alpha, size_t(width) * height);
+    sums.fill(0);
+    quint32 *sum = sums.data();
+
+    for (int y = 0; y < qMin(radius, height); ++y) {
+        const uchar *in = source.constData() + y * width;
+        for (int x = 0; x < width; ++x) sum[x] += in[x];
+    }
+    for (int y = 0; y < height; ++y) {
+        if (y + radius < height) {
+            const uchar *in = source.constData() + (y + radius) * width;
+            for (int x = 0; x < width; ++x) sum[x] += in[x];
+        }
+        uchar *out = alpha + y * width;
+        for (int x = 0; x < width; ++x) out[x] = uchar((sum[x] * scale + (1u << 15)) >> 16);
+        if (y - radius >= 0) {
+            const uchar *in = source.constData() + (y - radius) * width;
+            for (int x = 0; x < width; ++x) sum[x] -= in[x];
+        }
+    }
+}
+
+// Filled-arc brushes by gradient, ring and span in tenths of a degree. Rings
+// that show the same values, or come back to them, reuse the brush and with
+// it QPainter's cached color ramp.
+struct FilledBrushKey {
+    QVector<QRgb> table;
+    QRect rect;
+    int span;
+
+    bool operator==(const FilledBrushKey &other) const {
+        return span == other.span && rect == other.rect && table == other.table;
+    }
+};
+
+inline uint qHash(const FilledBrushKey &key, uint seed = 0) {
+    return ::qHash(key.rect.x(), seed) ^ ::qHash(key.rect.y() * 31 + key.rect.width(), seed) ^ uint(key.span * 2654435761u);
+}
+
+// Rasterizer workers build brushes too
+QMutex g_filledBrushMutex;
+QCache<FilledBrushKey, QBrush> g_filledBrushes(1024);
+
+// The filled span changes with every value, so this one is a conical gradient
+// with a few stops sampled from the table instead of a texture.
+QBrush filledArcBrush(const CircularProgressStyle &style, const QRect &ringRect, qreal spanDeg) {
+    const QVector<QRgb> table = tableFor(style);
+    const int samples = 32;
+    qreal span = qBound<qreal>(1.0, spanDeg, 360.0);
+
+    FilledBrushKey key{table, ringRect, qRound(span * 10)};
+    QMutexLocker locker(&g_filledBrushMutex);
+    if (const QBrush *cached = g_filledBrushes.object(key)) return *cached;
+    span = key.span / 10.0;
+
+    // Conical gradients run counter-clockwise from their angle, so starting at
+    // 12 o'clock the arc covers positions 1 down to 1 - span / 360.
+    QConicalGradient conical(QRectF(ringRect).center(), 90);
+    qreal gap = 1.0 - span / 360.0;
+    if (gap > 0) {
+        conical.setColorAt(0.0, QColor::fromRgba(table.first()));
+        conical.setColorAt(gap / 2, QColor::fromRgba(table.first()));
+        conical.setColorAt(qMin(gap, gap / 2 + 0.001), QColor::fromRgba(table.last()));
+    }
+    for (int i = 0; i <= samples; ++i) {
+        qreal t = qreal(i) / samples;
+        conical.setColorAt(1.0 - t * span / 360.0,
+                           QColor::fromRgba(CircularProgressRenderer::gradientColor(table, t)));
+    }
+    QBrush brush(conical);
+    g_filledBrushes.insert(key, new QBrush(brush));
+    return brush;
+}
+
+void paintSpinnerFrame(QPainter *painter, const CircularProgressFrame &frame) {
+    CircularProgressRenderer::drawSpinner(painter, frame.ringRect, *frame.progressPen, frame.startAngle,
+                                          frame.style->chunkLength);
+}
+
+// Same calls as the determinate half of drawFrame(), with every feature
+// test resolved when the variant was picked
+template <bool Label, bool Highlight, bool FilledGradient>
+void paintProgressFrame(QPainter *painter, const CircularProgressFrame &frame) {
+    const CircularProgressStyle &style = *frame.style;
+    if (Highlight && frame.progress > style.highlightThreshold) {
+        CircularProgressRenderer::drawProgress(painter, frame.ringRect, *frame.highlightPen,
+                                               frame.progress, style.circularDegree);
+    } else if (FilledGradient) {
+        QPen pen = CircularProgressRenderer::progressPen(style, frame.ringRect, frame.progress * style.circularDegree,
+                                                         painter->device()->devicePixelRatioF());
+        CircularProgressRenderer::drawProgress(painter, frame.ringRect, pen, frame.progress, style.circularDegree);
+    } else {
+        CircularProgressRenderer::drawProgress(painter, frame.ringRect, *frame.progressPen,
+                                               frame.progress, style.circularDegree);
+    }
+
+    if (Label) {
+        painter->setPen(style.textColor);
+        CircularProgressRenderer::drawLabel(painter, frame.ringRect, *frame.label);
+    }
+}
+
+}
+
+CircularProgressTheme::CircularProgressTheme() : d(new Data) {
+}
+
+CircularProgressTheme::CircularProgressTheme(const CircularProgressStyle &style) : d(new Data) {
+    d->style = style;
+}
+
+void CircularProgressTheme::setGradientColors(const QMap<qreal, QColor> &stops) {
+    d->style.gradientColors = stops;
+    d->style.gradientTable = CircularProgressRenderer::gradientTable(stops);
+}
+
+QRect CircularProgressRenderer::ringRect(const QRect &bounds, const CircularProgressStyle &style) {
+    int pnwidth = bounds.width() - style.progressWidth;
+    int pnheight = bounds.height() - style.progressWidth;
+    int margin = style.progressWidth / 2;
+    return QRect(bounds.x() + margin, bounds.y() + margin, pnwidth, pnheight);
+}
+
+void CircularProgressRenderer::setArcBackend(ArcBackend backend) {
+    g_arcBackend.store(backend, std::memory_order_relaxed);
+}
+
+CircularProgressRenderer::ArcBackend CircularProgressRenderer::arcBackend() {
+    return ArcBackend(g_arcBackend.load(std::memory_order_relaxed));
+}
+
+QPen CircularProgressRenderer::trackPen(const CircularProgressStyle &style) {
+    QPen pen;
+    pen.setColor(style.backgroundColor);
+    pen.setWidth(style.progressWidth);
+    pen.setCosmetic(true);
+    if (style.roundedCap) pen.setCapStyle(Qt::RoundCap);
+    return pen;
+}
+
+QPen CircularProgressRenderer::progressPen(const CircularProgressStyle &style, const QRect &ringRect, qreal dpr) {
+    QPen pen;
+    pen.setWidth(style.progressWidth);
+    pen.setCosmetic(true);
+    if (style.roundedCap) pen.setCapStyle(Qt::RoundCap);
+    pen.setColor(style.chunkColor);
+
+    if (!style.gradient) return pen;
+
+    if (style.gradientMode == CircularProgressStyle::LinearGradient) {
+        QLinearGradient linearGrad(ringRect.topLeft(), ringRect.bottomRight());
+        for (auto it = style.gradientColors.begin(); it != style.gradientColors.end(); ++it) {
+            linearGrad.setColorAt(it.key(), it.value());
+        }
+        pen.setBrush(linearGrad);
+    } else {
+        // Spinners have no filled part, FilledArcGradient falls back to the whole ring
+        pen.setBrush(arcTextureBrush(style, ringRect, dpr));
+    }
+    return pen;
+}
+
+QPen CircularProgressRenderer::progressPen(const CircularProgressStyle &style, const QRect &ringRect, qreal spanDeg,
+                                          qreal dpr) {
+    if (!style.gradient || style.gradientMode != CircularProgressStyle::FilledArcGradient)
+        return progressPen(style, ringRect, dpr);
+
+    QPen pen;
+    pen.setWidth(style.progressWidth);
+    pen.setCosmetic(true);
+    if (style.roundedCap) pen.setCapStyle(Qt::RoundCap);
+    pen.setBrush(filledArcBrush(style, ringRect, spanDeg));
+    return pen;
+}
+
+QPen CircularProgressRenderer::highlightPen(const CircularProgressStyle &style) {
+    QPen pen;
+    pen.setWidth(style.progressWidth);
+    pen.setCosmetic(true);
+    if (style.roundedCap) pen.setCapStyle(Qt::RoundCap);
+    pen.setColor(style.highlightColor);
+    return pen;
+}
+
+void CircularProgressRenderer::drawTrack(QPainter *painter, const QRect &ringRect, const CircularProgressStyle &style) {
+    painter->setPen(trackPen(style));
+    strokeArc(painter, ringRect, 90 * 16, -style.circularDegree * 16);
+}
+
+int CircularProgressRenderer::shadowMargin(const CircularProgressStyle &style) {
+    return style.shadowBlurRadius + style.shadowOffset.manhattanLength();
+}
+
+QImage CircularProgressRenderer::shadowImage(const QSize &size, qreal dpr, const QRect &ringRect,
+                                             const CircularProgressStyle &style) {
+    QImage image(size * dpr, QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(dpr);
+    image.fill(Qt::transparent);
+    if (image.isNull()) return image;
+
+    // Silhouette of the full ring, offset like the shadow falls
+    QPainter painter(&image);
+    painter.setRenderHints(QPainter::Antialiasing);
+    QPen pen = trackPen(style);
+    pen.setColor(Qt::black);
+    painter.setPen(pen);
+    painter.drawArc(ringRect.translated(style.shadowOffset), 90 * 16, -style.circularDegree * 16);
+    painter.end();
+
+    const int width = image.width(), height = image.height();
+    QVector<uchar> alpha(width * height);
+    for (int y = 0; y < height; ++y) {
+        const QRgb *line = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+        uchar *out = alpha.data() + y * width;
+        for (int x = 0; x < width; ++x) out[x] = uchar(qAlpha(line[x]));
+    }
+    blurAlpha(alpha.data(), width, height, qRound(style.shadowBlurRadius * dpr));
+
+    // Tint through a table of the 256 possible premultiplied colors
+    QRgb tint[256];
+    QRgb color = style.shadowColor.rgba();
+    for (int a = 0; a < 256; ++a)
+        tint[a] = qPremultiply(qRgba(qRed(color), qGreen(color), qBlue(color), (qAlpha(color) * a + 127) / 255));
+    for (int y = 0; y < height; ++y) {
+        QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+        const uchar *in = alpha.constData() + y * width;
+        for (int x = 0; x < width; ++x) line[x] = tint[in[x]];
+    }
+    return image;
+}
+
+void CircularProgressRenderer::blurAlpha(uchar *alpha, int width, int height, int radius) {
+    if (width <= 0 || height <= 0 || radius <= 0) return;
+
+    // Three passes of a third of the radius each
+    int box = qMax(1, (radius + 2) / 3);
+    QVector<uchar> line(width);
+    QVector<uchar> source(width * height);
+    QVector<quint32> sums(width);
+    for (int pass = 0; pass < 3; ++pass) {
+        boxBlurRows(alpha, width, height, box, line.data());
+        boxBlurColumns(alpha, width, height, box, source, sums);
+    }
+}
+
+void CircularProgressRenderer::drawProgress(QPainter *painter, const QRect &ringRect, const QPen &pen,
+                                            qreal progress, int circularDegree) {
+    painter->setPen(pen);
+    strokeArc(painter, ringRect, 90 * 16, int(-(progress * circularDegree * 16)));
+}
+
+void CircularProgressRenderer::drawSpinner(QPainter *painter, const QRect &ringRect, const QPen &pen,
+                                           int startAngle, double chunkLength) {
+    painter->setPen(pen);
+    strokeArc(painter, ringRect, 90 * 16 + startAngle * 16, int(-(chunkLength * 16)));
+}
+
+void CircularProgressRenderer::drawArc(QPainter *painter, const QRect &ringRect, const QPen &pen,
+                                       qreal start, qreal span) {
+    painter->setPen(pen);
+    strokeArc(painter, ringRect, qRound((90 - start) * 16), -qRound(span * 16));
+}
+
+void CircularProgressRenderer::drawLabel(QPainter *painter, const QRect &ringRect, const QStaticText &label) {
+    QSize textSize = label.size().toSize();
+    painter->drawStaticText(
+        ringRect.center().x() - textSize.width() / 2,
+        ringRect.center().y() - textSize.height() / 2,
+        label);
+}
+
+QVector<QRgb> CircularProgressRenderer::gradientTable(const QMap<qreal, QColor> &stops) {
+    // QGradient without stops goes from black to white
+    QMap<qreal, QColor> points = stops;
+    if (points.isEmpty()) {
+        points[0.0] = Qt::black;
+        points[1.0] = Qt::white;
+    }
+
+    QVector<qreal> positions;
+    QVector<float> colors;
+    for (auto it = points.begin(); it != points.end(); ++it) {
+        positions.append(qBound<qreal>(0.0, it.key(), 1.0));
+        colors << it.value().redF() << it.value().greenF() << it.value().blueF() << it.value().alphaF();
+    }
+
+    QVector<QRgb> table(GradientTableSize);
+    int segment = 0;
+    for (int i = 0; i < GradientTableSize; ++i) {
+        qreal t = qreal(i) / (GradientTableSize - 1);
+        while (segment + 1 < positions.size() && positions.at(segment + 1) < t) ++segment;
+
+        const float *from = colors.constData() + segment * 4;
+        const float *to = colors.constData() + qMin(segment + 1, positions.size() - 1) * 4;
+        qreal length = segment + 1 < positions.size() ? positions.at(segment + 1) - positions.at(segment) : 0;
+        float f = length > 0 ? float(qBound<qreal>(0.0, (t - positions.at(segment)) / length, 1.0))
+                             : (t < positions.at(segment) ? 0.0f : 1.0f);
+
+        // All four channels in one straight loop, compilers vectorize this
+        float rgba[4];
+        for (int c = 0; c < 4; ++c) rgba[c] = (from[c] + (to[c] - from[c]) * f) * 255.0f + 0.5f;
+        table[i] = qRgba(int(rgba[0]), int(rgba[1]), int(rgba[2]), int(rgba[3]));
+    }
+    return table;
+}
+
+QRgb CircularProgressRenderer::gradientColor(const QVector<QRgb> &table, qreal position) {
+    if (table.isEmpty()) return 0;
+    int index = qRound(qBound<qreal>(0.0, position, 1.0) * (table.size() - 1));
+    return table.at(index);
+}
+
+qreal CircularProgressRenderer::arcGradientPosition(qreal angle, qreal sweepDeg) {
+    if (sweepDeg <= 0) return 0.0;
+
+    angle = std::fmod(angle, 360.0);
+    if (angle < 0) angle += 360.0;
+    if (sweepDeg < 360.0 && angle > sweepDeg + (360.0 - sweepDeg) / 2) angle -= 360.0;
+    return qBound<qreal>(0.0, angle / sweepDeg, 1.0);
+}
+
+QString CircularProgressRenderer::labelText(int percent, const QString &suffix) {
+    return QString::number(percent) + suffix;
+}
+
+void CircularProgressRenderer::drawFrame(QPainter *painter, const QRect &ringRect, const CircularProgressStyle &style,
+                                         const QPen &progressPen, const QPen &highlightPen,
+                                         qreal progress, int startAngle, bool infinite, const QStaticText *label) {
+    if (infinite) {
+        drawSpinner(painter, ringRect, progressPen, startAngle, style.chunkLength);
+        return;
+    }
+
+    // Only a gradient stretched over the filled part depends on the value
+    bool filledGradient = style.gradient && style.gradientMode == CircularProgressStyle::FilledArcGradient;
+    QPen pen = progress > style.highlightThreshold ? highlightPen
+             : filledGradient ? CircularProgressRenderer::progressPen(style, ringRect, progress * style.circularDegree,
+                                                                      painter->device()->devicePixelRatioF())
+                              : progressPen;
+    drawProgress(painter, ringRect, pen, progress, style.circularDegree);
+
+    if (label) {
+        painter->setPen(style.textColor);
+        drawLabel(painter, ringRect, *label);
+    }
+}
+
+CircularProgressRenderer::FramePainter CircularProgressRenderer::framePainter(
+    const CircularProgressStyle &style, const QPen &progressPen, const QPen &highlightPen, bool infinite) {
+    if (infinite) return paintSpinnerFrame;
+
+    static const FramePainter painters[8] = {
+        paintProgressFrame<false, false, false>, paintProgressFrame<false, false, true>,
+        paintProgressFrame<false, true, false>,  paintProgressFrame<false, true, true>,
+        paintProgressFrame<true, false, false>,  paintProgressFrame<true, false, true>,
+        paintProgressFrame<true, true, false>,   paintProgressFrame<true, true, true>,
+    };
+
+    bool filled = style.gradient && style.gradientMode == CircularProgressStyle::FilledArcGradient;
+    // Progress never exceeds 1, and switching to an identical pen changes nothing
+    bool highlight = style.highlightThreshold < 1.0 && (filled || highlightPen != progressPen);
+    return painters[(style.textEnabled ? 4 : 0) | (highlight ? 2 : 0) | (filled ? 1 : 0)];
+}
+
+void CircularProgressRenderer::paint(QPainter *painter, const QRect &bounds, const CircularProgressStyle &style,
+                                     qreal progress, int startAngle, bool infinite) {
+    painter->save();
+    painter->setRenderHints(QPainter::Antialiasing);
+
+    QRect rect = ringRect(bounds, style);
+    qreal dpr = painter->device()->devicePixelRatioF();
+    if (style.backgroundEnabled) drawTrack(painter, rect, style);
+
+    if (infinite) {
+        drawSpinner(painter, rect, progressPen(style, rect, dpr), startAngle, style.chunkLength);
+    } else {
+        QPen pen = progress > style.highlightThreshold ? highlightPen(style)
+                                                       : progressPen(style, rect, progress * style.circularDegree, dpr);
+        drawProgress(painter, rect, pen, progress, style.circularDegree);
+
+        if (style.textEnabled) {
+            painter->setPen(style.textColor);
+            QStaticText label(labelText(static_cast<int>(progress * 100), style.suffix));
+            label.setTextFormat(Qt::PlainText);
+            drawLabel(painter, rect, label);
+        }
+    }
+
+    painter->restore();
+}
+
+const QStaticText &CircularProgressLabelCache::label(int percent, const QString &suffix, const QFont &font) {
+    if (suffix != m_suffix || font != m_font) {
+        m_labels.clear();
+        m_suffix = suffix;
+        m_font = font;
+    }
+
+    percent = qBound(0, percent, 100);
+    if (m_labels.isEmpty()) m_labels.resize(101);
+
+    QStaticText &label = m_labels[percent];
+    if (label.text().isEmpty()) {
+        label.setTextFormat(Qt::PlainText);
+        label.setText(CircularProgressRenderer::labelText(percent, suffix));
+        label.prepare(QTransform(), font);
+    }
+    return label;
+}
+
+void CircularProgressLabelCache::clear() {
+    m_labels.clear();
+}
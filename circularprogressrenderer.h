@@ -0,0 +1,182 @@
+#ifndef CIRCULARPROGRESSRENDERER_H
+#define CIRCULARPROGRESSRENDERER_H
+
+#include <QBrush>
+#include <QColor>
+#include <QFont>
+#include <QImage>
+#include <QMap>
+#include <QPainter>
+#include <QPen>
+#include <QPoint>
+#include <QRect>
+#include <QSharedData>
+#include <QSharedDataPointer>
+#include <QStaticText>
+#include <QString>
+#include <QVector>
+
+// Everything needed to draw a ring, independent of any widget.
+// Field defaults match a freshly constructed CircularProgressBar.
+struct CircularProgressStyle {
+    // How gradientColors are laid out on the ring
+    enum GradientMode {
+        LinearGradient,    // straight across the ring, top-left to bottom-right
+        ArcGradient,       // along the ring, 0 at its start and 1 at circularDegree
+        FilledArcGradient  // along the ring, stretched over the filled part only
+    };
+
+    int circularDegree = 360;
+    int progressWidth = 10;
+    bool roundedCap = true;
+    bool backgroundEnabled = true;
+    bool gradient = false;
+    bool textEnabled = true;
+    double chunkLength = 135;
+    qreal highlightThreshold = 0.85;
+
+    QColor backgroundColor = QColor(20, 20, 20, 255);
+    QColor chunkColor = QColor(73, 139, 209);
+    QColor highlightColor = QColor(71, 158, 245);
+    QColor textColor = QColor(73, 139, 209);
+    GradientMode gradientMode = LinearGradient;
+    QMap<qreal, QColor> gradientColors;
+    // gradientColors sampled by CircularProgressRenderer::gradientTable().
+    // Arc modes build it on the fly when empty, owners keep it filled.
+    QVector<QRgb> gradientTable;
+    QString suffix = "%";
+
+    // Drop shadow of the whole ring under the track, blurred into the cached
+    // layer. The ring shrinks by shadowMargin() to make room for it.
+    bool shadow = false;
+    QColor shadowColor = QColor(0, 0, 0, 110);
+    int shadowBlurRadius = 8;
+    QPoint shadowOffset = QPoint(0, 2);
+};
+
+// Implicitly shared CircularProgressStyle. Copies share one style until one
+// of them is edited, so a theme applied to thousands of bars is stored once.
+class CircularProgressTheme {
+public:
+    CircularProgressTheme();
+    explicit CircularProgressTheme(const CircularProgressStyle &style);
+
+    const CircularProgressStyle &style() const { return d->style; }
+    const CircularProgressStyle *operator->() const { return &d->style; }
+    // Detaches from other copies first
+    CircularProgressStyle &edit() { return d->style; }
+
+    // Also fills gradientTable, which arc gradients need
+    void setGradientColors(const QMap<qreal, QColor> &stops);
+
+    bool isSharedWith(const CircularProgressTheme &other) const { return d == other.d; }
+
+private:
+    struct Data : QSharedData {
+        CircularProgressStyle style;
+    };
+    QSharedDataPointer<Data> d;
+};
+
+// Arguments of one frame for CircularProgressRenderer::FramePainter
+struct CircularProgressFrame {
+    QRect ringRect;
+    const CircularProgressStyle *style = nullptr;
+    const QPen *progressPen = nullptr;
+    const QPen *highlightPen = nullptr;
+    qreal progress = 0;
+    int startAngle = 0;
+    const QStaticText *label = nullptr;
+};
+
+// Stateless drawing routines shared by CircularProgressBar, its caches and
+// CircularProgressDelegate. Angles follow QPainter::drawArc(): the ring
+// starts at 12 o'clock and progresses clockwise.
+class CircularProgressRenderer {
+public:
+    // Rect of the arc's center line inside bounds, inset by half the pen
+    static QRect ringRect(const QRect &bounds, const CircularProgressStyle &style);
+
+    static constexpr int GradientTableSize = 256;
+
+    // How arcs are stroked. AnalyticArcs hands solid antialiased arcs to
+    // ArcRasterizer whenever the painter draws into a raster image, QPainter
+    // strokes the rest. Applies to the whole process; PathStroker by default.
+    enum ArcBackend { PathStroker, AnalyticArcs };
+    static void setArcBackend(ArcBackend backend);
+    static ArcBackend arcBackend();
+
+    static QPen trackPen(const CircularProgressStyle &style);
+    // Arc gradients are textures; they are built for dpr to stay sharp, and
+    // cost a pass over the ring's bounding box, so keep the pen around
+    static QPen progressPen(const CircularProgressStyle &style, const QRect &ringRect, qreal dpr = 1.0);
+    // Same as above, but FilledArcGradient is stretched over spanDeg degrees,
+    // rounded to a tenth; those brushes are cached by gradient, rect and span
+    static QPen progressPen(const CircularProgressStyle &style, const QRect &ringRect, qreal spanDeg, qreal dpr);
+    static QPen highlightPen(const CircularProgressStyle &style);
+
+    static void drawTrack(QPainter *painter, const QRect &ringRect, const CircularProgressStyle &style);
+    // Blurred shadow of the whole ring in an image of size at dpr, ready to
+    // be drawn under the track. Meant to be cached, it costs a full blur.
+    // Only what lies inside size is kept; keep shadowMargin() free around
+    // the ring's bounds.
+    static int shadowMargin(const CircularProgressStyle &style);
+    static QImage shadowImage(const QSize &size, qreal dpr, const QRect &ringRect, const CircularProgressStyle &style);
+    // Three box blur passes over an 8-bit alpha buffer, close to a Gaussian
+    // that reaches radius pixels. Cost doesn't depend on the radius.
+    static void blurAlpha(uchar *alpha, int width, int height, int radius);
+    static void drawProgress(QPainter *painter, const QRect &ringRect, const QPen &pen,
+                             qreal progress, int circularDegree);
+    static void drawSpinner(QPainter *painter, const QRect &ringRect, const QPen &pen,
+                            int startAngle, double chunkLength);
+    // Any part of the ring, start and span in degrees clockwise from
+    // 12 o'clock, through the same backend as the arcs above
+    static void drawArc(QPainter *painter, const QRect &ringRect, const QPen &pen, qreal start, qreal span);
+    static void drawLabel(QPainter *painter, const QRect &ringRect, const QStaticText &label);
+
+    // Colors of stops interpolated at GradientTableSize evenly spaced positions
+    static QVector<QRgb> gradientTable(const QMap<qreal, QColor> &stops);
+    static QRgb gradientColor(const QVector<QRgb> &table, qreal position);
+    // Position in 0..1 of angle (degrees clockwise from 12 o'clock) on an arc
+    // sweeping sweepDeg. The gap after the arc is split between both ends.
+    static qreal arcGradientPosition(qreal angle, qreal sweepDeg);
+
+    static QString labelText(int percent, const QString &suffix);
+
+    // Arc or spinner and label as CircularProgressBar::paintEvent() draws them
+    // over its cached track, so off-screen renderers produce the same pixels.
+    // Pens come from progressPen() and highlightPen(); label may be null.
+    static void drawFrame(QPainter *painter, const QRect &ringRect, const CircularProgressStyle &style,
+                          const QPen &progressPen, const QPen &highlightPen,
+                          qreal progress, int startAngle, bool infinite, const QStaticText *label);
+
+    // drawFrame() specialized at compile time for one configuration (spinner,
+    // label, highlight switch, filled-arc gradient), so the call made every
+    // frame has no branches or pens for features the ring doesn't use.
+    // Pick again whenever the style, the pens or infinite mode change; the
+    // label must be set when style.textEnabled is, as drawFrame() draws it.
+    using FramePainter = void (*)(QPainter *painter, const CircularProgressFrame &frame);
+    static FramePainter framePainter(const CircularProgressStyle &style, const QPen &progressPen,
+                                     const QPen &highlightPen, bool infinite);
+
+    // Complete ring in one call; progress is 0..1 and startAngle only
+    // matters when infinite is set. Builds the pens on every call, so
+    // repeated frames should cache them and use drawFrame().
+    static void paint(QPainter *painter, const QRect &bounds, const CircularProgressStyle &style,
+                      qreal progress, int startAngle = 0, bool infinite = false);
+};
+
+// The label only ever shows 0..100 plus a suffix, so every label is shaped once
+// and reused. The cache drops itself when the suffix or font changes.
+class CircularProgressLabelCache {
+public:
+    const QStaticText &label(int percent, const QString &suffix, const QFont &font);
+    void clear();
+
+private:
+    QVector<QStaticText> m_labels;
+    QString m_suffix;
+    QFont m_font;
+};
+
+#endif // CIRCULARPROGRESSRENDERER_H
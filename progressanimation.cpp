@@ -0,0 +1,75 @@
+#include "progressanimation.h"
+#include <cmath>
+
+void ProgressValueAnimation::setMode(Mode mode) {
+    if (mode == m_mode) return;
+
+    m_mode = mode;
+    m_running = false;
+}
+
+void ProgressValueAnimation::start(float from, float to) {
+    if (m_mode == Spring) {
+        if (!m_running) {
+            m_position = from;
+            m_velocity = 0.0f;
+        }
+        m_to = to;
+        m_running = true;
+        return;
+    }
+
+    m_from = from;
+    m_to = to;
+    m_duration = m_fixedDuration > 0 ? m_fixedDuration
+                                     : qBound(100, static_cast<int>(std::abs(to - from) * 1000), 1000);
+    m_elapsed = 0;
+    m_running = true;
+}
+
+float ProgressValueAnimation::advance(qint64 delta) {
+    if (!m_running) return m_to;
+    if (m_mode == Spring) return advanceSpring(delta);
+
+    m_elapsed += delta;
+    float t = qMin(1.0f, static_cast<float>(m_elapsed) / m_duration);
+    if (t >= 1.0f) {
+        m_running = false;
+        return m_to;
+    }
+    return m_from + (m_to - m_from) * static_cast<float>(m_easingCurve.valueForProgress(t));
+}
+
+float ProgressValueAnimation::advanceSpring(qint64 delta) {
+    // Closed-form critically damped step, exact for any delta so late frames
+    // neither overshoot nor slow the motion down
+    const float omega = 6000.0f / m_springResponse;
+    const float t = delta / 1000.0f;
+    const float offset = m_position - m_to;
+    const float decay = std::exp(-omega * t);
+    const float slope = m_velocity + omega * offset;
+
+    m_position = m_to + (offset + slope * t) * decay;
+    m_velocity = (m_velocity - omega * slope * t) * decay;
+
+    // Converged below a tenth of a degree on a full ring
+    if (std::abs(m_position - m_to) < 2e-4f && std::abs(m_velocity) < 2e-3f) {
+        m_running = false;
+        m_position = m_to;
+        m_velocity = 0.0f;
+    }
+    return m_position;
+}
+
+int SpinnerPhase::duration() const {
+    return qFuzzyIsNull(m_velocity) ? 0 : qRound(Step * 1000.0 / std::abs(m_velocity));
+}
+
+int SpinnerPhase::angleAt(qint64 msec) const {
+    const qint64 stepsPerTurn = 360 / Step;
+    qint64 steps = static_cast<qint64>(std::floor(msec * m_velocity / (1000.0 * Step)));
+    steps = ((steps % stepsPerTurn) + stepsPerTurn) % stepsPerTurn;
+
+    // The chunk moves clockwise, i.e. towards smaller start angles
+    return static_cast<int>((stepsPerTurn - steps) % stepsPerTurn) * Step;
+}
@@ -0,0 +1,86 @@
+#ifndef PROGRESSANIMATION_H
+#define PROGRESSANIMATION_H
+
+#include <QEasingCurve>
+#include <QtGlobal>
+
+// Transition of the displayed progress, advanced by frame deltas.
+// Shared by CircularProgressBar and CircularProgressItem so both animate alike.
+//
+// Eased runs the easing curve from the current value to the target and starts
+// over on every new target. Spring keeps a critically damped spring running
+// instead: new targets only move its rest point, position and velocity carry
+// over, so rapid updates blend into one continuous motion.
+class ProgressValueAnimation {
+public:
+    enum Mode {
+        Eased,
+        Spring
+    };
+
+    // Switching modes stops a running animation
+    void setMode(Mode mode);
+    Mode mode() const { return m_mode; }
+
+    void setEasingCurve(const QEasingCurve &curve) { m_easingCurve = curve; }
+    const QEasingCurve &easingCurve() const { return m_easingCurve; }
+
+    // Eased: every transition takes msec; 0 scales it with the distance
+    void setDuration(int msec) { m_fixedDuration = qMax(0, msec); }
+    int duration() const { return m_fixedDuration; }
+
+    // Time for the spring to cover about 98% of a jump
+    void setSpringResponse(int msec) { m_springResponse = qMax(1, msec); }
+    int springResponse() const { return m_springResponse; }
+
+    // Eased: unless fixed, duration scales with the distance, 100 ms minimum,
+    // 1 s for the full range.
+    // Spring: from is only used when the spring is at rest.
+    void start(float from, float to);
+    void stop() { m_running = false; }
+    bool isRunning() const { return m_running; }
+    float target() const { return m_to; }
+
+    // Value for the frame after delta ms; stops itself once the end is reached
+    float advance(qint64 delta);
+
+private:
+    float advanceSpring(qint64 delta);
+
+    Mode m_mode = Eased;
+    QEasingCurve m_easingCurve = QEasingCurve(QEasingCurve::OutQuart);
+    float m_from = 0.0f;
+    float m_to = 0.0f;
+    int m_duration = 200;
+    int m_fixedDuration = 0;
+    qint64 m_elapsed = 0;
+    bool m_running = false;
+
+    int m_springResponse = 300;
+    float m_position = 0.0f;
+    float m_velocity = 0.0f;  // progress per second
+};
+
+// Infinite-mode chunk rotation as a function of the driver clock.
+// Late or dropped frames skip ahead instead of slowing the spinner down, any
+// tick rate gives the same speed, and spinners with equal speed stay in sync.
+class SpinnerPhase {
+public:
+    static constexpr int Step = 6;
+
+    // Clockwise degrees per second
+    void setAngularVelocity(qreal degreesPerSecond) { m_velocity = degreesPerSecond; }
+    qreal angularVelocity() const { return m_velocity; }
+
+    // Speed as milliseconds per 6° step, as setDuration() always took it
+    void setDuration(int msec) { m_velocity = Step * 1000.0 / qMax(1, msec); }
+    int duration() const;
+
+    // Start angle at clock time msec, snapped to whole steps
+    int angleAt(qint64 msec) const;
+
+private:
+    qreal m_velocity = Step * 1000.0 / 18;
+};
+
+#endif // PROGRESSANIMATION_H
@@ -0,0 +1,84 @@
+#include "progressanimationdriver.h"
+#include <QCoreApplication>
+#include <QPointer>
+
+ProgressAnimationDriver::ProgressAnimationDriver(QObject *parent) : QObject(parent) {
+    m_timer = new QTimer(this);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    m_timer->setInterval(m_interval);
+    m_monotonic.start();
+
+    connect(m_timer, &QTimer::timeout, this, &ProgressAnimationDriver::tick);
+}
+
+ProgressAnimationDriver *ProgressAnimationDriver::instance() {
+    static QPointer<ProgressAnimationDriver> driver;
+    if (!driver) driver = new ProgressAnimationDriver(QCoreApplication::instance());
+    return driver;
+}
+
+void ProgressAnimationDriver::registerClient(ProgressAnimationClient *client) {
+    if (!client || m_clients.contains(client)) return;
+
+    m_clients.append(client);
+    setRunning(true);
+}
+
+void ProgressAnimationDriver::unregisterClient(ProgressAnimationClient *client) {
+    int index = m_clients.indexOf(client);
+    if (index < 0) return;
+
+    // Keep indices stable while a tick is iterating; holes are compacted afterwards
+    if (m_ticking) {
+        m_clients[index] = nullptr;
+        return;
+    }
+
+    m_clients.remove(index);
+    if (m_clients.isEmpty()) setRunning(false);
+}
+
+void ProgressAnimationDriver::setInterval(int msec) {
+    m_interval = qMax(1, msec);
+    m_timer->setInterval(m_interval);
+}
+
+int ProgressAnimationDriver::registeredCount() const {
+    return m_clients.size() - m_clients.count(nullptr);
+}
+
+void ProgressAnimationDriver::setClock(ProgressAnimationClock *clock) {
+    m_clock = clock;
+}
+
+void ProgressAnimationDriver::processFrame() {
+    if (!m_ticking) tick();
+}
+
+void ProgressAnimationDriver::tick() {
+    m_frameTime = elapsed();
+
+    // Every client is advanced in the same pass, so their update() calls land
+    // in the same paint cycle instead of being spread across the frame.
+    m_ticking = true;
+    for (int i = 0; i < m_clients.size(); ++i) {
+        if (ProgressAnimationClient *client = m_clients.at(i))
+            client->advanceAnimation(m_frameTime);
+    }
+    m_ticking = false;
+
+    m_clients.removeAll(nullptr);
+    emit frameFinished(m_frameTime);
+
+    if (m_clients.isEmpty()) setRunning(false);
+}
+
+void ProgressAnimationDriver::setRunning(bool run) {
+    if (m_timer->isActive() == run) return;
+
+    if (run)
+        m_timer->start();
+    else
+        m_timer->stop();
+    emit activeChanged(run);
+}
@@ -0,0 +1,84 @@
+#ifndef PROGRESSANIMATIONDRIVER_H
+#define PROGRESSANIMATIONDRIVER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QVector>
+
+// Anything the shared driver can advance: CircularProgressBar, CircularProgressItem
+class ProgressAnimationClient {
+public:
+    virtual ~ProgressAnimationClient() = default;
+    virtual void advanceAnimation(qint64 frameTime) = 0;
+};
+
+// Time source of the driver in milliseconds. Defaults to a monotonic clock;
+// deterministic runs install a ProgressVirtualClock and call processFrame().
+class ProgressAnimationClock {
+public:
+    virtual ~ProgressAnimationClock() = default;
+    virtual qint64 now() const = 0;
+};
+
+class ProgressVirtualClock : public ProgressAnimationClock {
+public:
+    qint64 now() const override { return m_now; }
+    void setTime(qint64 msec) { m_now = msec; }
+    void advance(qint64 msec) { m_now += msec; }
+
+private:
+    qint64 m_now = 0;
+};
+
+// Process-wide frame clock shared by every progress ring.
+// Clients register only while they have something to animate; the driver
+// advances all of them from a single timer tick and stops when idle.
+class ProgressAnimationDriver : public QObject {
+    Q_OBJECT
+
+public:
+    static ProgressAnimationDriver *instance();
+
+    void registerClient(ProgressAnimationClient *client);
+    void unregisterClient(ProgressAnimationClient *client);
+
+    // Animations follow the clock, so a longer interval (e.g. 50 ms under
+    // load) lowers the frame rate without changing their speed
+    void setInterval(int msec);
+    int interval() const { return m_interval; }
+    int registeredCount() const;
+    bool isActive() const { return m_timer->isActive(); }
+
+    // The clock is not owned; nullptr restores the monotonic clock
+    void setClock(ProgressAnimationClock *clock);
+    ProgressAnimationClock *clock() const { return m_clock; }
+
+    // Milliseconds since the driver was created, or the installed clock's time
+    qint64 elapsed() const { return m_clock ? m_clock->now() : m_monotonic.elapsed(); }
+    qint64 frameTime() const { return m_frameTime; }
+
+    // Advances every registered client right away, without waiting for the timer
+    void processFrame();
+
+signals:
+    void frameFinished(qint64 frameTime);
+    // The timer started or stopped; frame gaps across a stop measure idle
+    // time, not load
+    void activeChanged(bool active);
+
+private:
+    explicit ProgressAnimationDriver(QObject *parent = nullptr);
+    void tick();
+    void setRunning(bool run);
+
+    QTimer *m_timer = nullptr;
+    QElapsedTimer m_monotonic;
+    ProgressAnimationClock *m_clock = nullptr;
+    QVector<ProgressAnimationClient *> m_clients;
+    qint64 m_frameTime = 0;
+    int m_interval = 16;
+    bool m_ticking = false;
+};
+
+#endif // PROGRESSANIMATIONDRIVER_H
@@ -0,0 +1,165 @@
+#include "progressinstrumentation.h"
+#include "progressanimationdriver.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QPointer>
+#include <QTimer>
+#include <QVariantList>
+
+Q_LOGGING_CATEGORY(lcCircularProgressStats, "circularprogress.stats")
+
+namespace {
+
+ProgressStats &globalStatsStorage() {
+    static ProgressStats stats;
+    return stats;
+}
+
+QPointer<QTimer> &reportTimer() {
+    static QPointer<QTimer> timer;
+    return timer;
+}
+
+// Global late frames are judged once per driver frame in which any
+// instrumented ring ticked
+struct FrameTracking {
+    bool connected = false;
+    bool ticked = false;
+    qint64 lastFrame = -1;
+};
+
+FrameTracking &frameTracking() {
+    static FrameTracking tracking;
+    return tracking;
+}
+
+void frameFinished(qint64 frameTime) {
+    FrameTracking &tracking = frameTracking();
+    qint64 interval = ProgressAnimationDriver::instance()->interval();
+    if (tracking.ticked && tracking.lastFrame >= 0 && (frameTime - tracking.lastFrame) * 2 > interval * 3)
+        ++globalStatsStorage().lateFrames;
+    tracking.lastFrame = frameTime;
+    tracking.ticked = false;
+}
+
+void driverActiveChanged(bool active) {
+    // A restarted driver's first frame follows idle time, not a late tick
+    if (active) frameTracking().lastFrame = -1;
+}
+
+}
+
+void ProgressStats::recordPaint(qint64 nsecs) {
+    ++paints;
+    paintNsecs += nsecs;
+    maxPaintNsecs = qMax(maxPaintNsecs, nsecs);
+
+    qint64 usecs = nsecs / 1000;
+    int bucket = 0;
+    while (bucket < PaintBuckets - 1 && usecs >= PaintBucketLimits[bucket]) ++bucket;
+    ++paintHistogram[bucket];
+}
+
+void ProgressStats::merge(const ProgressStats &other) {
+    paints += other.paints;
+    paintNsecs += other.paintNsecs;
+    maxPaintNsecs = qMax(maxPaintNsecs, other.maxPaintNsecs);
+    for (int i = 0; i < PaintBuckets; ++i) paintHistogram[i] += other.paintHistogram[i];
+
+    ticks += other.ticks;
+    spinnerSteps += other.spinnerSteps;
+    animationRestarts += other.animationRestarts;
+    lateFrames += other.lateFrames;
+}
+
+QVariantMap ProgressStats::toVariantMap() const {
+    QVariantList histogram;
+    for (int i = 0; i < PaintBuckets; ++i) histogram.append(paintHistogram[i]);
+
+    QVariantList limits;
+    for (qint64 limit : PaintBucketLimits) limits.append(limit);
+
+    QVariantMap map;
+    map["paints"] = paints;
+    map["paint_mean_us"] = meanPaintNsecs() / 1000.0;
+    map["paint_max_us"] = maxPaintNsecs / 1000.0;
+    map["paint_histogram"] = histogram;
+    map["paint_histogram_limits_us"] = limits;
+    map["ticks"] = ticks;
+    map["spinner_steps"] = spinnerSteps;
+    map["animation_restarts"] = animationRestarts;
+    map["late_frames"] = lateFrames;
+    return map;
+}
+
+QDebug operator<<(QDebug debug, const ProgressStats &stats) {
+    QDebugStateSaver saver(debug);
+    debug.nospace() << "ProgressStats(paints " << stats.paints
+                    << ", mean " << stats.meanPaintNsecs() / 1000.0 << " us"
+                    << ", max " << stats.maxPaintNsecs / 1000.0 << " us"
+                    << ", histogram [";
+    for (int i = 0; i < ProgressStats::PaintBuckets; ++i)
+        debug << (i ? " " : "") << stats.paintHistogram[i];
+    debug << "], ticks " << stats.ticks
+          << ", spinner steps " << stats.spinnerSteps
+          << ", animation restarts " << stats.animationRestarts
+          << ", late frames " << stats.lateFrames << ')';
+    return debug;
+}
+
+const ProgressStats &ProgressInstrumentation::globalStats() {
+    return globalStatsStorage();
+}
+
+void ProgressInstrumentation::resetGlobalStats() {
+    globalStatsStorage() = ProgressStats();
+}
+
+void ProgressInstrumentation::setReportInterval(int msec) {
+    QPointer<QTimer> &timer = reportTimer();
+    if (msec <= 0) {
+        delete timer;
+        return;
+    }
+
+    if (!timer) {
+        timer = new QTimer(QCoreApplication::instance());
+        QObject::connect(timer, &QTimer::timeout, []() {
+            qCInfo(lcCircularProgressStats) << "all rings:" << globalStats();
+        });
+    }
+    timer->start(msec);
+}
+
+int ProgressInstrumentation::reportInterval() {
+    QTimer *timer = reportTimer();
+    return timer ? timer->interval() : 0;
+}
+
+void ProgressInstrumentation::recordPaint(ProgressStats &stats, qint64 nsecs) {
+    stats.recordPaint(nsecs);
+    globalStatsStorage().recordPaint(nsecs);
+}
+
+void ProgressInstrumentation::recordTick(ProgressStats &stats, bool late, int spinnerSteps) {
+    for (ProgressStats *target : {&stats, &globalStatsStorage()}) {
+        ++target->ticks;
+        target->spinnerSteps += spinnerSteps;
+    }
+    if (late) ++stats.lateFrames;
+
+    FrameTracking &tracking = frameTracking();
+    tracking.ticked = true;
+    if (!tracking.connected) {
+        ProgressAnimationDriver *driver = ProgressAnimationDriver::instance();
+        QObject::connect(driver, &ProgressAnimationDriver::frameFinished, driver, frameFinished);
+        QObject::connect(driver, &ProgressAnimationDriver::activeChanged, driver, driverActiveChanged);
+        tracking.lastFrame = driver->frameTime();
+        tracking.connected = true;
+    }
+}
+
+void ProgressInstrumentation::recordAnimationRestart(ProgressStats &stats) {
+    ++stats.animationRestarts;
+    ++globalStatsStorage().animationRestarts;
+}
@@ -0,0 +1,64 @@
+#ifndef PROGRESSINSTRUMENTATION_H
+#define PROGRESSINSTRUMENTATION_H
+
+#include <QLoggingCategory>
+#include <QVariantMap>
+#include <QtGlobal>
+
+class QDebug;
+
+// Statistics are logged under "circularprogress.stats", e.g.
+// QT_LOGGING_RULES="circularprogress.stats.debug=true"
+Q_DECLARE_LOGGING_CATEGORY(lcCircularProgressStats)
+
+// Frame and animation counters of one ring, or of all instrumented rings
+struct ProgressStats {
+    // Upper bounds of the paint duration buckets in microseconds,
+    // the last bucket collects everything slower
+    static constexpr int PaintBuckets = 10;
+    static constexpr qint64 PaintBucketLimits[PaintBuckets - 1] = {
+        50, 100, 250, 500, 1000, 2000, 4000, 8000, 16000
+    };
+
+    quint64 paints = 0;
+    qint64 paintNsecs = 0;
+    qint64 maxPaintNsecs = 0;
+    quint64 paintHistogram[PaintBuckets] = {};
+
+    quint64 ticks = 0;              // driver frames delivered to the ring
+    quint64 spinnerSteps = 0;       // chunk positions advanced in infinite mode
+    quint64 animationRestarts = 0;  // value animations (re)started
+    // Ticks arriving over 1.5 intervals after the previous one. Globally
+    // these are driver frames, counted once however many rings ticked in them.
+    quint64 lateFrames = 0;
+
+    void recordPaint(qint64 nsecs);
+    void merge(const ProgressStats &other);
+    qint64 meanPaintNsecs() const { return paints ? paintNsecs / qint64(paints) : 0; }
+
+    // Plain map for feeding monitoring systems
+    QVariantMap toVariantMap() const;
+};
+
+QDebug operator<<(QDebug debug, const ProgressStats &stats);
+
+// Process-wide side of the instrumentation. Rings only record anything after
+// CircularProgressBar::setInstrumentationEnabled(true); all of it is GUI-thread only.
+class ProgressInstrumentation {
+public:
+    // Sum of every instrumented ring since start or the last reset
+    static const ProgressStats &globalStats();
+    static void resetGlobalStats();
+
+    // Logs globalStats() to lcCircularProgressStats every msec; 0 stops it
+    static void setReportInterval(int msec);
+    static int reportInterval();
+
+    // Record into a ring's stats and the global ones at once. Late ticks
+    // only count for the ring; the global count comes from the driver.
+    static void recordPaint(ProgressStats &stats, qint64 nsecs);
+    static void recordTick(ProgressStats &stats, bool late, int spinnerSteps);
+    static void recordAnimationRestart(ProgressStats &stats);
+};
+
+#endif // PROGRESSINSTRUMENTATION_H
@@ -0,0 +1,105 @@
+#include "progressqualitygovernor.h"
+#include "progressanimationdriver.h"
+#include "progressinstrumentation.h"
+#include <QCoreApplication>
+#include <QPointer>
+
+ProgressQualityGovernor::ProgressQualityGovernor(QObject *parent) : QObject(parent) {
+}
+
+ProgressQualityGovernor *ProgressQualityGovernor::instance() {
+    static QPointer<ProgressQualityGovernor> governor;
+    if (!governor) governor = new ProgressQualityGovernor(QCoreApplication::instance());
+    return governor;
+}
+
+void ProgressQualityGovernor::setEnabled(bool enable) {
+    if (m_enabled == enable) return;
+
+    m_enabled = enable;
+    m_lastFrameTime = -1;
+    m_lateRun = m_headroomRun = 0;
+
+    ProgressAnimationDriver *driver = ProgressAnimationDriver::instance();
+    if (m_enabled) {
+        connect(driver, &ProgressAnimationDriver::frameFinished, this, &ProgressQualityGovernor::frameFinished);
+        connect(driver, &ProgressAnimationDriver::activeChanged, this, &ProgressQualityGovernor::driverActiveChanged);
+    } else {
+        disconnect(driver, &ProgressAnimationDriver::frameFinished, this, &ProgressQualityGovernor::frameFinished);
+        disconnect(driver, &ProgressAnimationDriver::activeChanged, this, &ProgressQualityGovernor::driverActiveChanged);
+        applyLevel(Full);
+    }
+}
+
+void ProgressQualityGovernor::setLevel(Level level) {
+    applyLevel(Level(qBound(0, int(level), int(m_maxLevel))));
+}
+
+void ProgressQualityGovernor::setMaxLevel(Level level) {
+    m_maxLevel = Level(qBound(0, int(level), LevelCount - 1));
+    if (m_level > m_maxLevel) applyLevel(m_maxLevel);
+}
+
+void ProgressQualityGovernor::setThresholds(qreal degradeFactor, qreal restoreFactor) {
+    m_degradeFactor = qMax<qreal>(1.0, degradeFactor);
+    m_restoreFactor = qBound<qreal>(1.0, restoreFactor, m_degradeFactor);
+}
+
+void ProgressQualityGovernor::setHoldFrames(int degradeFrames, int restoreFrames) {
+    m_degradeFrames = qMax(1, degradeFrames);
+    m_restoreFrames = qMax(1, restoreFrames);
+}
+
+ProgressQualityGovernor::Degradations ProgressQualityGovernor::degradationsFor(int level) {
+    Degradations degradations;
+    if (level >= SolidColor) degradations |= DropGradient;
+    if (level >= Aliased) degradations |= DropAntialiasing;
+    if (level >= StaticText) degradations |= FreezeText;
+    return degradations;
+}
+
+void ProgressQualityGovernor::frameFinished(qint64 frameTime) {
+    const int interval = ProgressAnimationDriver::instance()->interval();
+    qint64 gap = frameTime - m_lastFrameTime;
+    bool first = m_lastFrameTime < 0;
+    m_lastFrameTime = frameTime;
+    if (first) return;
+
+    m_smoothed = m_smoothed > 0 ? m_smoothed + (gap - m_smoothed) * 0.2 : gap;
+
+    if (m_smoothed > interval * m_degradeFactor) {
+        m_headroomRun = 0;
+        if (++m_lateRun >= m_degradeFrames && m_level < m_maxLevel) applyLevel(Level(m_level + 1));
+    } else if (m_smoothed < interval * m_restoreFactor) {
+        m_lateRun = 0;
+        if (++m_headroomRun >= m_restoreFrames && m_level > Full) applyLevel(Level(m_level - 1));
+    } else {
+        // Between the thresholds both runs start over
+        m_lateRun = m_headroomRun = 0;
+    }
+}
+
+void ProgressQualityGovernor::driverActiveChanged(bool active) {
+    // The driver stops while idle, the first frame after a restart measures nothing
+    if (active) m_lastFrameTime = -1;
+}
+
+void ProgressQualityGovernor::applyLevel(Level level) {
+    m_lateRun = m_headroomRun = 0;
+    if (level == m_level) return;
+
+    // Animations follow the clock, so halving the rate keeps their speed
+    ProgressAnimationDriver *driver = ProgressAnimationDriver::instance();
+    if (level >= ReducedRate && m_level < ReducedRate) {
+        m_baseInterval = driver->interval();
+        driver->setInterval(m_baseInterval * 2);
+    } else if (level < ReducedRate && m_level >= ReducedRate && m_baseInterval > 0) {
+        driver->setInterval(m_baseInterval);
+    }
+    // The new rate is a new baseline
+    m_smoothed = 0;
+
+    qCInfo(lcCircularProgressStats) << "quality level" << m_level << "->" << level;
+    m_level = level;
+    emit levelChanged(m_level);
+}
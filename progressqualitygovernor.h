@@ -0,0 +1,91 @@
+#ifndef PROGRESSQUALITYGOVERNOR_H
+#define PROGRESSQUALITYGOVERNOR_H
+
+#include <QObject>
+
+// Process-wide rendering quality under load. While enabled it watches the
+// shared driver's frame times and steps down one level at a time when frames
+// run late, and back up once they have had headroom for a while. Levels are
+// cumulative: each one keeps the degradations of the levels below it.
+// Bars follow the current level unless their own policy pins or limits it.
+class ProgressQualityGovernor : public QObject {
+    Q_OBJECT
+
+public:
+    enum Level {
+        Full,         // everything as configured
+        ReducedRate,  // driver ticks at half rate
+        SolidColor,   // gradients drawn in the chunk color
+        Aliased,      // no antialiasing on small rings
+        StaticText,   // labels jump to the target instead of counting along
+        LevelCount
+    };
+    Q_ENUM(Level)
+
+    // What a bar may change about its own drawing, one flag per level above ReducedRate
+    enum Degradation {
+        NoDegradation = 0x0,
+        DropGradient = 0x1,
+        DropAntialiasing = 0x2,
+        FreezeText = 0x4,
+        AllDegradations = DropGradient | DropAntialiasing | FreezeText
+    };
+    Q_DECLARE_FLAGS(Degradations, Degradation)
+
+    static ProgressQualityGovernor *instance();
+
+    // Off by default. Disabling restores Full.
+    void setEnabled(bool enable);
+    bool isEnabled() const { return m_enabled; }
+
+    Level level() const { return m_level; }
+    // Jumps to a level directly, e.g. to start an embedded panel degraded.
+    // While enabled the governor keeps adjusting from there.
+    void setLevel(Level level);
+    void setMaxLevel(Level level);
+    Level maxLevel() const { return m_maxLevel; }
+
+    // Frames are late above degradeFactor times the driver interval and have
+    // headroom below restoreFactor times it. A level changes only after that
+    // many frames in a row, so a single hitch or lull doesn't flip it.
+    void setThresholds(qreal degradeFactor, qreal restoreFactor);
+    void setHoldFrames(int degradeFrames, int restoreFrames);
+
+    // Rings smaller than this (in pixels, either side) lose antialiasing at Aliased
+    void setSmallRingSize(int pixels) { m_smallRingSize = pixels; }
+    int smallRingSize() const { return m_smallRingSize; }
+
+    // Exponentially smoothed time between driver frames in milliseconds
+    qreal smoothedFrameTime() const { return m_smoothed; }
+
+    static Degradations degradationsFor(int level);
+
+signals:
+    void levelChanged(int level);
+
+private:
+    explicit ProgressQualityGovernor(QObject *parent = nullptr);
+    void frameFinished(qint64 frameTime);
+    void driverActiveChanged(bool active);
+    void applyLevel(Level level);
+
+    bool m_enabled = false;
+    Level m_level = Full;
+    Level m_maxLevel = StaticText;
+    qreal m_degradeFactor = 1.5;
+    qreal m_restoreFactor = 1.15;
+    int m_degradeFrames = 8;
+    int m_restoreFrames = 90;
+    int m_smallRingSize = 64;
+
+    qint64 m_lastFrameTime = -1;
+    qreal m_smoothed = 0;
+    int m_lateRun = 0;
+    int m_headroomRun = 0;
+    // Driver interval before ReducedRate halved it
+    int m_baseInterval = 0;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(ProgressQualityGovernor::Degradations)
+
+#endif // PROGRESSQUALITYGOVERNOR_H
@@ -0,0 +1,146 @@
+#include "progressrasterizer.h"
+#include <QMetaObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QObject>
+#include <QPainter>
+#include <QRunnable>
+#include <QScopedPointer>
+#include <QThread>
+#include <QThreadPool>
+#include <utility>
+
+// Shared between the ring and its job, so a job outliving the ring stays valid
+struct ProgressRasterizer::Shared {
+    QMutex mutex;
+    QObject *receiver = nullptr;
+    std::function<void()> ready;
+    bool notifyQueued = false;
+
+    bool busy = false;
+    bool hasPending = false;
+    ProgressFrameState pending;
+    quint64 pendingSequence = 0;
+    quint64 requested = 0;
+
+    QImage frame;
+    quint64 frameSequence = 0;
+    quint64 dropped = 0;
+};
+
+class ProgressRasterizer::Job : public QRunnable {
+public:
+    Job(const QSharedPointer<Shared> &shared, const ProgressFrameState &state, quint64 sequence)
+        : m_shared(shared), m_state(state), m_sequence(sequence) {}
+
+    void run() override {
+        // Keeps going while newer states arrived during the last frame
+        for (;;) {
+            QImage image = ProgressRasterizer::render(m_state);
+
+            QMutexLocker locker(&m_shared->mutex);
+            if (m_sequence > m_shared->frameSequence) {
+                m_shared->frame = image;
+                m_shared->frameSequence = m_sequence;
+                notify();
+            }
+
+            if (!m_shared->hasPending) {
+                m_shared->busy = false;
+                return;
+            }
+            m_state = std::move(m_shared->pending);
+            m_sequence = m_shared->pendingSequence;
+            m_shared->pending = ProgressFrameState();
+            m_shared->hasPending = false;
+        }
+    }
+
+private:
+    // Called with the mutex held, which keeps the receiver alive
+    void notify() {
+        if (!m_shared->receiver || m_shared->notifyQueued) return;
+
+        m_shared->notifyQueued = true;
+        QSharedPointer<Shared> shared = m_shared;
+        QMetaObject::invokeMethod(m_shared->receiver, [shared]() {
+            QMutexLocker locker(&shared->mutex);
+            shared->notifyQueued = false;
+            std::function<void()> ready = shared->ready;
+            locker.unlock();
+            if (ready) ready();
+        }, Qt::QueuedConnection);
+    }
+
+    QSharedPointer<Shared> m_shared;
+    ProgressFrameState m_state;
+    quint64 m_sequence;
+};
+
+ProgressRasterizer::ProgressRasterizer(QObject *receiver, std::function<void()> ready) : d(new Shared) {
+    d->receiver = receiver;
+    d->ready = std::move(ready);
+}
+
+ProgressRasterizer::~ProgressRasterizer() {
+    QMutexLocker locker(&d->mutex);
+    d->receiver = nullptr;
+    d->ready = nullptr;
+    d->hasPending = false;
+    d->pending = ProgressFrameState();
+}
+
+void ProgressRasterizer::request(const ProgressFrameState &state) {
+    QMutexLocker locker(&d->mutex);
+    quint64 sequence = ++d->requested;
+    if (d->busy) {
+        if (d->hasPending) ++d->dropped;
+        d->pending = state;
+        d->pendingSequence = sequence;
+        d->hasPending = true;
+        return;
+    }
+
+    d->busy = true;
+    locker.unlock();
+    pool()->start(new Job(d, state, sequence));
+}
+
+QImage ProgressRasterizer::frame() const {
+    QMutexLocker locker(&d->mutex);
+    return d->frame;
+}
+
+quint64 ProgressRasterizer::droppedFrames() const {
+    QMutexLocker locker(&d->mutex);
+    return d->dropped;
+}
+
+QThreadPool *ProgressRasterizer::pool() {
+    static QScopedPointer<QThreadPool> pool([]() {
+        auto *threads = new QThreadPool;
+        threads->setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+        return threads;
+    }());
+    return pool.data();
+}
+
+QImage ProgressRasterizer::render(const ProgressFrameState &state) {
+    QImage image(state.size * state.dpr, QImage::Format_ARGB32_Premultiplied);
+    image.setDevicePixelRatio(state.dpr);
+    image.fill(Qt::transparent);
+    if (image.isNull()) return image;
+
+    const CircularProgressStyle &style = state.theme.style();
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing, state.antialiasing);
+
+    // Label caches are per thread, so the label is shaped with the frame
+    CircularProgressLabelCache labels;
+    const QStaticText *label = style.textEnabled && !state.infinite
+        ? &labels.label(state.labelPercent, style.suffix, state.font) : nullptr;
+    CircularProgressRenderer::drawFrame(&painter, state.ringRect, style, state.progressPen, state.highlightPen,
+                                        state.progress, state.startAngle, state.infinite, label);
+    painter.end();
+    return image;
+}
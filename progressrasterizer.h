@@ -0,0 +1,64 @@
+#ifndef PROGRESSRASTERIZER_H
+#define PROGRESSRASTERIZER_H
+
+#include <QFont>
+#include <QImage>
+#include <QPen>
+#include <QRect>
+#include <QSharedPointer>
+#include <QSize>
+#include <functional>
+#include "circularprogressrenderer.h"
+
+class QObject;
+class QThreadPool;
+
+// Everything one frame of a ring depends on, copied on the GUI thread.
+// Theme, pens and font are implicitly shared, so taking a snapshot is cheap
+// and editing the ring afterwards detaches instead of racing the worker.
+struct ProgressFrameState {
+    CircularProgressTheme theme;
+    QPen progressPen;
+    QPen highlightPen;
+    QFont font;
+    QSize size;       // frame size in device independent pixels
+    qreal dpr = 1.0;
+    QRect ringRect;   // relative to the frame origin
+    qreal progress = 0;
+    int labelPercent = 0;
+    int startAngle = 0;
+    bool infinite = false;
+    bool antialiasing = true;
+};
+
+// Renders the moving part of a ring (arc or spinner and label) into images on
+// a shared worker pool, so the GUI thread only blits finished frames.
+// Each ring has at most one frame in flight. Requests made meanwhile replace
+// each other, so only the newest state is rendered and the rest are dropped.
+class ProgressRasterizer {
+public:
+    // ready is queued to receiver's thread when a newer frame is available,
+    // at most once until it has run
+    ProgressRasterizer(QObject *receiver, std::function<void()> ready);
+    // A frame still rendering finishes on its worker and is discarded
+    ~ProgressRasterizer();
+
+    void request(const ProgressFrameState &state);
+
+    // Newest completed frame, null before the first one
+    QImage frame() const;
+    // Requests replaced by a newer one before they were rendered
+    quint64 droppedFrames() const;
+
+    // Separate from the global pool so exports don't delay on-screen frames,
+    // and one thread short of the core count to leave room for the GUI thread
+    static QThreadPool *pool();
+    static QImage render(const ProgressFrameState &state);
+
+private:
+    struct Shared;
+    class Job;
+    QSharedPointer<Shared> d;
+};
+
+#endif // PROGRESSRASTERIZER_H
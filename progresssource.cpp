@@ -0,0 +1,149 @@
+#include "progresssource.h"
+#include <QDebug>
+#include <limits>
+
+quint64 ProgressSource::mulDiv(quint64 a, quint64 b, quint64 c) {
+#ifdef __SIZEOF_INT128__
+    return quint64((unsigned __int128)a * b / c);
+#else
+    // 64 x 64 -> 128 bit product in halves, then restoring division
+    quint64 aLo = a & 0xffffffffu, aHi = a >> 32;
+    quint64 bLo = b & 0xffffffffu, bHi = b >> 32;
+    quint64 ll = aLo * bLo, lh = aLo * bHi, hl = aHi * bLo, hh = aHi * bHi;
+    quint64 mid = (ll >> 32) + (lh & 0xffffffffu) + (hl & 0xffffffffu);
+    quint64 lo = (mid << 32) | (ll & 0xffffffffu);
+    quint64 hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+
+    quint64 quotient = 0, remainder = 0;
+    for (int bit = 127; bit >= 0; --bit) {
+        bool carry = remainder >> 63;
+        remainder = (remainder << 1) | ((bit >= 64 ? hi >> (bit - 64) : lo >> bit) & 1);
+        quotient <<= 1;
+        if (carry || remainder >= c) {
+            remainder -= c;
+            quotient |= 1;
+        }
+    }
+    return quotient;
+#endif
+}
+
+void ProgressSource::mapToRange(quint64 current, quint64 total, int *value, int *maximum) {
+    const quint64 limit = quint64(std::numeric_limits<int>::max());
+    current = qMin(current, total);
+    if (total <= limit) {
+        *maximum = int(total);
+        *value = int(current);
+        return;
+    }
+
+    *maximum = int(limit);
+    *value = int(mulDiv(current, limit, total));
+}
+
+SharedProgressSource::~SharedProgressSource() {
+    detach();
+}
+
+bool SharedProgressSource::mapFile(const QString &path) {
+    detach();
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Cannot open progress file" << path << m_file.errorString();
+        return false;
+    }
+    m_mapped = m_file.map(0, m_file.size());
+    return mapBlock(m_mapped, m_file.size(), false);
+}
+
+bool SharedProgressSource::attachSharedMemory(const QString &key) {
+    detach();
+    m_memory.setKey(key);
+    if (!m_memory.attach(QSharedMemory::ReadOnly)) {
+        qWarning() << "Cannot attach progress segment" << key << m_memory.errorString();
+        return false;
+    }
+    return mapBlock(static_cast<uchar *>(m_memory.data()), m_memory.size(), false);
+}
+
+bool SharedProgressSource::createFile(const QString &path) {
+    detach();
+    m_file.setFileName(path);
+    // Readers may still map an existing file; truncating it would make their
+    // pages fault, so it only ever grows
+    if (!m_file.open(QIODevice::ReadWrite)
+        || (m_file.size() < qint64(sizeof(SharedProgressBlock)) && !m_file.resize(sizeof(SharedProgressBlock)))) {
+        qWarning() << "Cannot create progress file" << path << m_file.errorString();
+        return false;
+    }
+    m_mapped = m_file.map(0, sizeof(SharedProgressBlock));
+    return mapBlock(m_mapped, sizeof(SharedProgressBlock), true);
+}
+
+bool SharedProgressSource::createSharedMemory(const QString &key) {
+    detach();
+    m_memory.setKey(key);
+    if (!m_memory.create(sizeof(SharedProgressBlock))) {
+        qWarning() << "Cannot create progress segment" << key << m_memory.errorString();
+        return false;
+    }
+    return mapBlock(static_cast<uchar *>(m_memory.data()), m_memory.size(), true);
+}
+
+bool SharedProgressSource::mapBlock(uchar *memory, qint64 size, bool initialize) {
+    if (!memory || size < qint64(sizeof(SharedProgressBlock))) {
+        qWarning() << "Progress block missing or too small:" << size << "bytes";
+        detach();
+        return false;
+    }
+
+    m_block = reinterpret_cast<SharedProgressBlock *>(memory);
+    if (initialize) {
+        // Readers ignore the block while it is rewritten
+        m_block->magic.store(0, std::memory_order_release);
+        m_block->version = SharedProgressBlock::Version;
+        m_block->current.store(0, std::memory_order_relaxed);
+        m_block->total.store(0, std::memory_order_relaxed);
+        m_block->magic.store(SharedProgressBlock::Magic, std::memory_order_release);
+    }
+    return true;
+}
+
+void SharedProgressSource::detach() {
+    m_block = nullptr;
+    if (m_mapped) m_file.unmap(m_mapped);
+    m_mapped = nullptr;
+    if (m_file.isOpen()) m_file.close();
+    if (m_memory.isAttached()) m_memory.detach();
+}
+
+void SharedProgressSource::setTotal(quint64 total) {
+    if (m_block) m_block->total.store(total, std::memory_order_release);
+}
+
+void SharedProgressSource::setCurrent(quint64 current) {
+    if (m_block) m_block->current.store(current, std::memory_order_release);
+}
+
+void SharedProgressSource::add(quint64 delta) {
+    if (m_block) m_block->current.fetch_add(delta, std::memory_order_release);
+}
+
+quint64 SharedProgressSource::current() const {
+    return m_block ? m_block->current.load(std::memory_order_acquire) : 0;
+}
+
+quint64 SharedProgressSource::total() const {
+    return m_block ? m_block->total.load(std::memory_order_acquire) : 0;
+}
+
+bool SharedProgressSource::sample(quint64 *current, quint64 *total) const {
+    if (!m_block || m_block->magic.load(std::memory_order_acquire) != SharedProgressBlock::Magic
+        || m_block->version != SharedProgressBlock::Version) {
+        return false;
+    }
+
+    *total = m_block->total.load(std::memory_order_acquire);
+    *current = m_block->current.load(std::memory_order_acquire);
+    return true;
+}
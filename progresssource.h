@@ -0,0 +1,83 @@
+#ifndef PROGRESSSOURCE_H
+#define PROGRESSSOURCE_H
+
+#include <QFile>
+#include <QSharedMemory>
+#include <QString>
+#include <atomic>
+
+// Something a CircularProgressBar polls once per displayed frame instead of
+// being told about every change. Sampling happens on the GUI thread and must
+// be cheap; the producer may be another thread or another process.
+class ProgressSource {
+public:
+    virtual ~ProgressSource() = default;
+
+    // Current and total work done. A total of 0 means unknown.
+    // Returns false while the source has nothing to report yet.
+    virtual bool sample(quint64 *current, quint64 *total) const = 0;
+
+    // Maps a 64-bit count onto QProgressBar's int range. Totals that fit are
+    // used as they are; larger ones are scaled exactly (floor of
+    // current * INT_MAX / total), so the maximum is only reached when done.
+    static void mapToRange(quint64 current, quint64 total, int *value, int *maximum);
+    // floor(value * numerator / denominator) without intermediate overflow,
+    // for results that fit in 64 bits
+    static quint64 mulDiv(quint64 value, quint64 numerator, quint64 denominator);
+};
+
+// Counter layout shared with the producing process. Plain lock-free atomics
+// at fixed offsets, so producers written in C or without Qt can use it too
+// and neither side makes a syscall after mapping.
+struct SharedProgressBlock {
+    static constexpr quint32 Magic = 0x42525043;  // "CPRB"
+    static constexpr quint32 Version = 1;
+
+    std::atomic<quint32> magic;    // stored last by the creator
+    quint32 version;
+    std::atomic<quint64> current;
+    std::atomic<quint64> total;    // 0 while unknown
+};
+
+static_assert(std::atomic<quint64>::is_always_lock_free, "shared counters need address-free atomics");
+
+// A ProgressSource reading SharedProgressBlock from a memory-mapped file or a
+// QSharedMemory segment. On Linux a POSIX segment from shm_open("/name") is
+// mapped with mapFile("/dev/shm/name"). The producer side uses the same
+// class with createFile() or createSharedMemory() and the setters.
+class SharedProgressSource : public ProgressSource {
+public:
+    SharedProgressSource() = default;
+    ~SharedProgressSource() override;
+
+    // Consumer side, read-only. sample() reports nothing until the producer
+    // has initialized the block.
+    bool mapFile(const QString &path);
+    bool attachSharedMemory(const QString &key);
+
+    // Producer side, starting at 0 of an unknown total. An existing file is
+    // reused in place, never truncated, so attached readers stay valid.
+    bool createFile(const QString &path);
+    bool createSharedMemory(const QString &key);
+
+    void detach();
+    bool isAttached() const { return m_block != nullptr; }
+
+    void setTotal(quint64 total);
+    void setCurrent(quint64 current);
+    void add(quint64 delta = 1);
+    quint64 current() const;
+    quint64 total() const;
+
+    bool sample(quint64 *current, quint64 *total) const override;
+
+private:
+    bool mapBlock(uchar *memory, qint64 size, bool initialize);
+
+    SharedProgressBlock *m_block = nullptr;
+    QFile m_file;
+    uchar *m_mapped = nullptr;
+    QSharedMemory m_memory;
+};
+
+#endif // PROGRESSSOURCE_H
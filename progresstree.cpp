@@ -0,0 +1,162 @@
+#include "progresstree.h"
+#include <QDebug>
+#include <QMutexLocker>
+
+namespace {
+// Units shared out from the root. Leaves of a tree with millions of nodes
+// still get enough of them to show fine steps.
+constexpr quint64 RootUnits = quint64(1) << 52;
+
+// Two updates of one leaf racing each other can reach an ancestor in either
+// order, so a sum may be seen briefly below 0 (wrapped) or above its total
+quint64 clampUnits(quint64 done, quint64 total) {
+    return quint64(qBound<qint64>(0, qint64(done), qint64(total)));
+}
+}
+
+ProgressTree::ProgressTree() {
+    clear();
+}
+
+ProgressTree::NodeId ProgressTree::addNode(NodeId parent, quint32 weight) {
+    if (parent < 0 || parent >= nodeCount()) {
+        qWarning() << "ProgressTree: no node" << parent;
+        return -1;
+    }
+
+    // Appending may reallocate what a sampling thread reads
+    QMutexLocker locker(&m_layoutMutex);
+    NodeId node = nodeCount();
+    m_parent.append(parent);
+    m_weight.append(weight);
+    m_childWeight.append(0);
+    m_childCount.append(0);
+    m_units.append(0);
+    m_total.append(0);
+    m_fraction.emplace_back(0);
+    m_done.emplace_back(0);
+    ++m_childCount[parent];
+    m_dirty.store(true, std::memory_order_release);
+    return node;
+}
+
+void ProgressTree::setWeight(NodeId node, quint32 weight) {
+    if (node < 0 || node >= nodeCount() || m_weight.at(node) == weight) return;
+
+    QMutexLocker locker(&m_layoutMutex);
+    m_weight[node] = weight;
+    m_dirty.store(true, std::memory_order_release);
+}
+
+void ProgressTree::reserve(int nodes) {
+    QMutexLocker locker(&m_layoutMutex);
+    m_parent.reserve(nodes);
+    m_weight.reserve(nodes);
+    m_childWeight.reserve(nodes);
+    m_childCount.reserve(nodes);
+    m_units.reserve(nodes);
+    m_total.reserve(nodes);
+}
+
+void ProgressTree::clear() {
+    QMutexLocker locker(&m_layoutMutex);
+    m_parent = {-1};
+    m_weight = {1};
+    m_childWeight = {0};
+    m_childCount = {0};
+    m_units = {0};
+    m_total = {0};
+    m_fraction.clear();
+    m_fraction.emplace_back(0);
+    m_done.clear();
+    m_done.emplace_back(0);
+    m_dirty.store(true, std::memory_order_release);
+}
+
+void ProgressTree::setProgress(NodeId leaf, quint64 current, quint64 total) {
+    setFixedProgress(leaf, total ? mulDiv(qMin(current, total), FractionOne, total) : 0);
+}
+
+void ProgressTree::setProgress(NodeId leaf, double fraction) {
+    setFixedProgress(leaf, quint64(qBound(0.0, fraction, 1.0) * FractionOne + 0.5));
+}
+
+void ProgressTree::setFixedProgress(NodeId leaf, quint64 fraction) {
+    if (leaf < 0 || leaf >= nodeCount() || m_childCount.at(leaf) > 0) return;
+    ensureLayout();
+
+    quint64 previous = m_fraction[leaf].exchange(fraction, std::memory_order_acq_rel);
+    if (previous == fraction) return;
+
+    // Unsigned wrap-around makes a decrease an add as well
+    quint64 units = m_units.at(leaf);
+    quint64 delta = mulDiv(fraction, units, FractionOne) - mulDiv(previous, units, FractionOne);
+    if (delta == 0) return;
+
+    for (NodeId node = leaf; node >= 0; node = m_parent.at(node))
+        m_done[node].fetch_add(delta, std::memory_order_release);
+}
+
+double ProgressTree::progress(NodeId node) const {
+    QMutexLocker locker(&m_layoutMutex);
+    if (node < 0 || node >= nodeCount()) return 0.0;
+    layoutIfDirty();
+
+    quint64 total = m_total.at(node);
+    if (total == 0) return 0.0;
+    return double(clampUnits(m_done[node].load(std::memory_order_acquire), total)) / total;
+}
+
+bool ProgressTree::sample(quint64 *current, quint64 *total) const {
+    // Uncontended once per frame; edits on another thread can't move the
+    // vectors underneath
+    QMutexLocker locker(&m_layoutMutex);
+    // A bar bound right after addNode(), setWeight() or clear() shows the
+    // new structure before any leaf reports
+    layoutIfDirty();
+
+    *total = m_total.at(Root);
+    *current = clampUnits(m_done[Root].load(std::memory_order_acquire), *total);
+    return true;
+}
+
+void ProgressTree::ensureLayout() {
+    if (!m_dirty.load(std::memory_order_acquire)) return;
+
+    // Only the first updates after a structure change get here
+    QMutexLocker locker(&m_layoutMutex);
+    layoutIfDirty();
+}
+
+void ProgressTree::layoutIfDirty() const {
+    if (!m_dirty.load(std::memory_order_relaxed)) return;
+    layout();
+    m_dirty.store(false, std::memory_order_release);
+}
+
+void ProgressTree::layout() const {
+    const int count = nodeCount();
+    m_childWeight.fill(0);
+    for (NodeId node = 1; node < count; ++node) m_childWeight[m_parent.at(node)] += m_weight.at(node);
+
+    // Parents come before their children, so one pass hands out the shares
+    m_units[Root] = RootUnits;
+    for (NodeId node = 1; node < count; ++node) {
+        NodeId parent = m_parent.at(node);
+        quint64 weights = m_childWeight.at(parent);
+        m_units[node] = weights ? mulDiv(m_units.at(parent), m_weight.at(node), weights) : 0;
+    }
+
+    // Leaves own their units, inner nodes sum those below them from the back
+    for (NodeId node = 0; node < count; ++node) {
+        bool leaf = m_childCount.at(node) == 0;
+        m_total[node] = leaf ? m_units.at(node) : 0;
+        quint64 done = leaf ? mulDiv(m_fraction[node].load(std::memory_order_relaxed), m_units.at(node), FractionOne) : 0;
+        m_done[node].store(done, std::memory_order_relaxed);
+    }
+    for (NodeId node = count - 1; node > 0; --node) {
+        NodeId parent = m_parent.at(node);
+        m_total[parent] += m_total.at(node);
+        m_done[parent].fetch_add(m_done[node].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef PROGRESSTREE_H
+#define PROGRESSTREE_H
+
+#include <QMutex>
+#include <QVector>
+#include <atomic>
+#include <deque>
+#include "progresssource.h"
+
+// Overall progress of a job made of weighted subtasks. Every node splits its
+// share of the whole among its children by weight; leaves report their own
+// progress. The share of each leaf is fixed-point, so an update only adds the
+// leaf's change to its ancestors: O(depth) lock-free atomics, from any thread.
+//
+// The structure (addNode(), setWeight(), clear()) is built from one thread
+// while no updates run; the first update or sample after a change lays the
+// tree out in O(n). Bind the tree to a bar with setProgressSource(). The bar samples the
+// root once per displayed frame, so any update rate is shown at most at the
+// frame rate. Sampling takes the layout lock and may go on while the
+// structure is edited.
+class ProgressTree : public ProgressSource {
+public:
+    using NodeId = int;
+    static constexpr NodeId Root = 0;
+    // Fixed-point one for leaf progress
+    static constexpr quint64 FractionOne = quint64(1) << 32;
+
+    ProgressTree();
+
+    // Children always get higher ids than their parent
+    NodeId addNode(NodeId parent = Root, quint32 weight = 1);
+    void setWeight(NodeId node, quint32 weight);
+    void reserve(int nodes);
+    void clear();
+    int nodeCount() const { return m_parent.size(); }
+    NodeId parent(NodeId node) const { return m_parent.value(node, -1); }
+    bool isLeaf(NodeId node) const { return m_childCount.value(node) == 0; }
+
+    // Leaf progress, from any thread. Inner nodes follow their children.
+    void setProgress(NodeId leaf, quint64 current, quint64 total);
+    void setProgress(NodeId leaf, double fraction);
+    void setFinished(NodeId leaf) { setFixedProgress(leaf, FractionOne); }
+
+    // Aggregated progress of a node's subtree, 0..1
+    double progress(NodeId node = Root) const;
+    // The root as fixed-point units, which only reach the total once every leaf is done
+    bool sample(quint64 *current, quint64 *total) const override;
+
+private:
+    void setFixedProgress(NodeId leaf, quint64 fraction);
+    // Recomputes shares and aggregates after the structure changed
+    void ensureLayout();
+    // Same with m_layoutMutex held, as readers lay the tree out too
+    void layoutIfDirty() const;
+    void layout() const;
+
+    // Structure, only touched while no updates run. The layout derived from
+    // it is a cache that readers may fill.
+    QVector<NodeId> m_parent;
+    QVector<quint32> m_weight;
+    mutable QVector<quint64> m_childWeight;
+    QVector<int> m_childCount;
+    mutable QVector<quint64> m_units;  // share of the whole
+    mutable QVector<quint64> m_total;  // units of the leaves below, what done reaches at the end
+
+    // Updated concurrently; deques never move their elements when growing
+    std::deque<std::atomic<quint64>> m_fraction;  // leaves, in 1 / FractionOne
+    mutable std::deque<std::atomic<quint64>> m_done;
+    mutable std::atomic<bool> m_dirty{true};
+    // Held by structure edits, the layout and readers, which may run on
+    // another thread than the edits
+    mutable QMutex m_layoutMutex;
+};
+
+#endif // PROGRESSTREE_H
@@ -0,0 +1,66 @@
+#include "spinneratlas.h"
+#include "circularprogressrenderer.h"
+#include <QPainter>
+#include <QPair>
+#include <QWeakPointer>
+
+namespace {
+// Few distinct spinner styles exist at once, a linear scan is enough
+QVector<QPair<SpinnerAtlasKey, QWeakPointer<SpinnerAtlas>>> &atlasRegistry() {
+    static QVector<QPair<SpinnerAtlasKey, QWeakPointer<SpinnerAtlas>>> registry;
+    return registry;
+}
+}
+
+bool SpinnerAtlasKey::operator==(const SpinnerAtlasKey &other) const {
+    return size == other.size
+           && qFuzzyCompare(dpr, other.dpr)
+           && rect == other.rect
+           && qFuzzyCompare(chunkLength, other.chunkLength)
+           && pen == other.pen;
+}
+
+SpinnerAtlas::SpinnerAtlas(const SpinnerAtlasKey &key) : m_key(key) {
+    m_frames.resize(FrameCount);
+}
+
+QSharedPointer<SpinnerAtlas> SpinnerAtlas::acquire(const SpinnerAtlasKey &key) {
+    auto &registry = atlasRegistry();
+
+    for (int i = registry.size() - 1; i >= 0; --i) {
+        QSharedPointer<SpinnerAtlas> atlas = registry.at(i).second.toStrongRef();
+        if (!atlas) {
+            registry.remove(i);
+        } else if (registry.at(i).first == key) {
+            return atlas;
+        }
+    }
+
+    QSharedPointer<SpinnerAtlas> atlas(new SpinnerAtlas(key));
+    registry.append(qMakePair(key, atlas.toWeakRef()));
+    return atlas;
+}
+
+int SpinnerAtlas::sharedCount() {
+    int count = 0;
+    for (const auto &entry : atlasRegistry()) {
+        if (!entry.second.isNull()) ++count;
+    }
+    return count;
+}
+
+const QPixmap &SpinnerAtlas::frame(int angle) {
+    int index = (qRound(angle / double(FrameStep)) % FrameCount + FrameCount) % FrameCount;
+    QPixmap &pixmap = m_frames[index];
+
+    if (pixmap.isNull()) {
+        pixmap = QPixmap(m_key.size * m_key.dpr);
+        pixmap.setDevicePixelRatio(m_key.dpr);
+        pixmap.fill(Qt::transparent);
+
+        QPainter painter(&pixmap);
+        painter.setRenderHints(QPainter::Antialiasing);
+        CircularProgressRenderer::drawSpinner(&painter, m_key.rect, m_key.pen, index * FrameStep, m_key.chunkLength);
+    }
+    return pixmap;
+}
@@ -0,0 +1,44 @@
+#ifndef SPINNERATLAS_H
+#define SPINNERATLAS_H
+
+#include <QPixmap>
+#include <QPen>
+#include <QRect>
+#include <QSharedPointer>
+#include <QVector>
+
+// Everything that influences how a spinner frame looks.
+// Instances with equal keys share one atlas.
+struct SpinnerAtlasKey {
+    QSize size;
+    qreal dpr = 1.0;
+    QRect rect;          // arc rect relative to the frame origin
+    double chunkLength = 0;
+    QPen pen;
+
+    bool operator==(const SpinnerAtlasKey &other) const;
+    bool operator!=(const SpinnerAtlasKey &other) const { return !(*this == other); }
+};
+
+// Pre-rendered rotation frames of the infinite-mode chunk.
+// The spinner advances in 6° steps, so one full turn is 60 frames;
+// frames are rendered on first use and kept for the atlas lifetime.
+class SpinnerAtlas {
+public:
+    static constexpr int FrameCount = 60;
+    static constexpr int FrameStep = 360 / FrameCount;
+
+    static QSharedPointer<SpinnerAtlas> acquire(const SpinnerAtlasKey &key);
+    static int sharedCount();
+
+    const SpinnerAtlasKey &key() const { return m_key; }
+    const QPixmap &frame(int angle);
+
+private:
+    explicit SpinnerAtlas(const SpinnerAtlasKey &key);
+
+    SpinnerAtlasKey m_key;
+    QVector<QPixmap> m_frames;
+};
+
+#endif // SPINNERATLAS_H